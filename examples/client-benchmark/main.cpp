@@ -34,10 +34,12 @@
 #include <iomanip>
 #include <iostream>
 #include <memory>
+#include <mutex>
 #include <random>
 #include <stdexcept>
 #include <thread>
 #include <unordered_map>
+#include <vector>
 
 using namespace rtc;
 using namespace std;
@@ -73,6 +75,24 @@ int bufferSize;
 const float STEP_COUNT_FOR_1_SEC = 100.0;
 const int stepDurationInMs = int(1000 / STEP_COUNT_FOR_1_SEC);
 
+// Benchmark - peerPairs params
+struct PeerPair {
+	std::mutex mutex;
+	shared_ptr<WebSocket> offererWs, answererWs;
+	shared_ptr<PeerConnection> offerer, answerer;
+	shared_ptr<DataChannel> dc, remoteDc;
+	steady_clock::time_point startTime;
+	optional<steady_clock::time_point> openTime; // guarded by mutex
+	atomic<size_t> receivedSize = 0;
+};
+
+int runPeerPairs(const Configuration &config, const string &baseUrl, int count, int duration);
+shared_ptr<WebSocket> openSignaling(const string &url, vector<future<void>> &futures);
+shared_ptr<PeerConnection> createPairPeerConnection(const Configuration &config,
+                                                    weak_ptr<WebSocket> wws, string id);
+void sendUntilBuffered(shared_ptr<DataChannel> dc);
+template <typename T> T percentile(const vector<T> &sorted, double p);
+
 int main(int argc, char **argv) try {
 	Cmdline params(argc, argv);
 
@@ -108,6 +128,19 @@ int main(int argc, char **argv) try {
 	localId = randomId(4);
 	cout << "The local ID is: " << localId << endl;
 
+	string wsPrefix = "";
+	if (params.webSocketServer().substr(0, 5).compare("ws://") != 0) {
+		wsPrefix = "ws://";
+	}
+	const string baseUrl =
+	    wsPrefix + params.webSocketServer() + ":" + to_string(params.webSocketPort()) + "/";
+
+	const int duration = params.durationInSec() > 0 ? params.durationInSec() : INT32_MAX;
+
+	// Load test: connect local peer pairs to each other
+	if (params.peerPairs() > 0)
+		return runPeerPairs(config, baseUrl, params.peerPairs(), duration);
+
 	auto ws = make_shared<WebSocket>();
 
 	std::promise<void> wsPromise;
@@ -161,12 +194,7 @@ int main(int argc, char **argv) try {
 		}
 	});
 
-	string wsPrefix = "";
-	if (params.webSocketServer().substr(0, 5).compare("ws://") != 0) {
-		wsPrefix = "ws://";
-	}
-	const string url = wsPrefix + params.webSocketServer() + ":" +
-	                   to_string(params.webSocketPort()) + "/" + localId;
+	const string url = baseUrl + localId;
 	cout << "Url is " << url << endl;
 	ws->open(url);
 
@@ -252,7 +280,6 @@ int main(int argc, char **argv) try {
 		dataChannelMap.emplace(label, dc);
 	}
 
-	const int duration = params.durationInSec() > 0 ? params.durationInSec() : INT32_MAX;
 	cout << "Benchmark will run for " << duration << " seconds" << endl;
 
 	int printCounter = 0;
@@ -472,6 +499,271 @@ shared_ptr<PeerConnection> createPeerConnection(const Configuration &config,
 	return pc;
 };
 
+// Connect peer pairs through the signaling server and report connection and throughput statistics
+int runPeerPairs(const Configuration &config, const string &baseUrl, int count, int duration) {
+	vector<shared_ptr<PeerPair>> pairs;
+	vector<future<void>> futures;
+
+	cout << "Connecting " << count << " peer pairs to signaling..." << endl;
+	for (int i = 0; i < count; ++i) {
+		auto pair = make_shared<PeerPair>();
+		const string offererId = localId + "-" + to_string(i) + "o";
+		const string answererId = localId + "-" + to_string(i) + "a";
+		pair->offererWs = openSignaling(baseUrl + offererId, futures);
+		pair->answererWs = openSignaling(baseUrl + answererId, futures);
+
+		pair->offererWs->onMessage([wpair = make_weak_ptr(pair)](variant<binary, string> data) {
+			auto pair = wpair.lock();
+			if (!pair || !holds_alternative<string>(data))
+				return;
+
+			json message = json::parse(get<string>(data));
+			string type = message.value("type", "");
+			shared_ptr<PeerConnection> pc;
+			{
+				std::lock_guard lock(pair->mutex);
+				pc = pair->offerer;
+			}
+			if (!pc)
+				return;
+
+			if (type == "answer") {
+				auto sdp = message["description"].get<string>();
+				pc->setRemoteDescription(Description(sdp, type));
+			} else if (type == "candidate") {
+				auto sdp = message["candidate"].get<string>();
+				auto mid = message["mid"].get<string>();
+				pc->addRemoteCandidate(Candidate(sdp, mid));
+			}
+		});
+
+		pair->answererWs->onMessage([config, offererId,
+		                             wpair = make_weak_ptr(pair)](variant<binary, string> data) {
+			auto pair = wpair.lock();
+			if (!pair || !holds_alternative<string>(data))
+				return;
+
+			json message = json::parse(get<string>(data));
+			string type = message.value("type", "");
+			std::unique_lock lock(pair->mutex);
+			if (type == "offer" && !pair->answerer) {
+				pair->answerer = createPairPeerConnection(config, pair->answererWs, offererId);
+				pair->answerer->onDataChannel([wpair](shared_ptr<DataChannel> dc) {
+					auto pair = wpair.lock();
+					if (!pair)
+						return;
+
+					dc->onMessage([wpair](variant<binary, string> data) {
+						if (auto pair = wpair.lock(); pair && holds_alternative<binary>(data))
+							pair->receivedSize += get<binary>(data).size();
+					});
+
+					std::lock_guard lock(pair->mutex);
+					pair->remoteDc = dc;
+				});
+			}
+
+			auto pc = pair->answerer;
+			lock.unlock();
+			if (!pc)
+				return;
+
+			if (type == "offer") {
+				auto sdp = message["description"].get<string>();
+				pc->setRemoteDescription(Description(sdp, type));
+			} else if (type == "candidate") {
+				auto sdp = message["candidate"].get<string>();
+				auto mid = message["mid"].get<string>();
+				pc->addRemoteCandidate(Candidate(sdp, mid));
+			}
+		});
+
+		pairs.push_back(std::move(pair));
+	}
+
+	for (auto &f : futures)
+		f.get();
+
+	cout << "Signaling ready, offering on " << count << " peer pairs" << endl;
+	const auto startTime = steady_clock::now();
+	auto openCount = make_shared<atomic<int>>(0);
+	for (int i = 0; i < count; ++i) {
+		auto &pair = pairs[i];
+		auto pc = createPairPeerConnection(config, pair->offererWs,
+		                                   localId + "-" + to_string(i) + "a");
+		{
+			std::lock_guard lock(pair->mutex);
+			pair->startTime = steady_clock::now();
+			pair->offerer = pc;
+		}
+
+		pair->dc = pc->createDataChannel("DC-1");
+		pair->dc->setBufferedAmountLowThreshold(bufferSize);
+
+		pair->dc->onOpen([openCount, wpair = make_weak_ptr(pair)]() {
+			auto pair = wpair.lock();
+			if (!pair)
+				return;
+
+			{
+				std::lock_guard lock(pair->mutex);
+				pair->openTime = steady_clock::now();
+			}
+			++*openCount;
+
+			if (!noSend)
+				sendUntilBuffered(pair->dc);
+		});
+
+		pair->dc->onBufferedAmountLow([wdc = make_weak_ptr(pair->dc)]() {
+			if (auto dc = wdc.lock(); dc && !noSend)
+				sendUntilBuffered(dc);
+		});
+	}
+
+	cout << "Benchmark will run for " << duration << " seconds" << endl;
+
+	auto printTime = steady_clock::now();
+	bool connectionPrinted = false;
+	for (int i = 1; i <= duration; ++i) {
+		this_thread::sleep_for(1s);
+
+		const double elapsedTimeInSecs =
+		    std::chrono::duration<double>(steady_clock::now() - printTime).count();
+		printTime = steady_clock::now();
+
+		vector<unsigned long> speeds;
+		speeds.reserve(pairs.size());
+		unsigned long speedTotal = 0;
+		for (const auto &pair : pairs) {
+			auto speed = static_cast<unsigned long>(pair->receivedSize.exchange(0) /
+			                                        (elapsedTimeInSecs * 1000));
+			speeds.push_back(speed);
+			speedTotal += speed;
+		}
+		std::sort(speeds.begin(), speeds.end());
+
+		cout << "#" << i << "   Open: " << *openCount << "/" << count
+		     << "   Received per pair (KB/s) p50: " << percentile(speeds, 0.50)
+		     << "   p90: " << percentile(speeds, 0.90) << "   p99: " << percentile(speeds, 0.99)
+		     << "   min: " << percentile(speeds, 0.) << "   TOTL: " << speedTotal << " KB/s"
+		     << endl;
+
+		if (connectionPrinted || (*openCount < count && i < duration))
+			continue;
+
+		vector<milliseconds> connectionTimes;
+		steady_clock::time_point lastOpenTime = startTime;
+		for (const auto &pair : pairs) {
+			std::lock_guard lock(pair->mutex);
+			if (!pair->openTime)
+				continue;
+
+			connectionTimes.push_back(
+			    std::chrono::duration_cast<milliseconds>(*pair->openTime - pair->startTime));
+			lastOpenTime = std::max(lastOpenTime, *pair->openTime);
+		}
+		std::sort(connectionTimes.begin(), connectionTimes.end());
+
+		const double openTimeInSecs =
+		    std::chrono::duration<double>(lastOpenTime - startTime).count();
+		cout << "Connection# Open: " << connectionTimes.size() << "/" << count << "   Rate: "
+		     << (openTimeInSecs > 0 ? int(connectionTimes.size() / openTimeInSecs) : 0)
+		     << " pairs/s   Time p50: " << percentile(connectionTimes, 0.50).count()
+		     << " ms   p90: " << percentile(connectionTimes, 0.90).count()
+		     << " ms   p99: " << percentile(connectionTimes, 0.99).count()
+		     << " ms   max: " << percentile(connectionTimes, 1.).count() << " ms" << endl;
+
+		connectionPrinted = true;
+	}
+
+	cout << "Cleaning up..." << endl;
+
+	for (auto &pair : pairs) {
+		std::unique_lock lock(pair->mutex);
+		auto offerer = std::move(pair->offerer);
+		auto answerer = std::move(pair->answerer);
+		pair->remoteDc.reset();
+		lock.unlock();
+
+		// Close outside the lock as callbacks might be pending
+		offerer->close();
+		if (answerer)
+			answerer->close();
+	}
+	pairs.clear();
+	return 0;
+}
+
+// Open a WebSocket to the signaling server, the future is set when it is open
+shared_ptr<WebSocket> openSignaling(const string &url, vector<future<void>> &futures) {
+	auto ws = make_shared<WebSocket>();
+	auto promise = make_shared<std::promise<void>>();
+	futures.push_back(promise->get_future());
+
+	ws->onOpen([promise]() {
+		try {
+			promise->set_value();
+		} catch (const std::future_error &) {
+			// already set
+		}
+	});
+
+	ws->onError([promise](string s) {
+		try {
+			promise->set_exception(std::make_exception_ptr(std::runtime_error(s)));
+		} catch (const std::future_error &) {
+			// already set
+		}
+	});
+
+	ws->open(url);
+	return ws;
+}
+
+// Create a PeerConnection which only forwards its description and candidates to signaling
+shared_ptr<PeerConnection> createPairPeerConnection(const Configuration &config,
+                                                    weak_ptr<WebSocket> wws, string id) {
+	auto pc = make_shared<PeerConnection>(config);
+
+	pc->onLocalDescription([wws, id](Description description) {
+		json message = {
+		    {"id", id}, {"type", description.typeString()}, {"description", string(description)}};
+
+		if (auto ws = wws.lock())
+			ws->send(message.dump());
+	});
+
+	pc->onLocalCandidate([wws, id](Candidate candidate) {
+		json message = {{"id", id},
+		                {"type", "candidate"},
+		                {"candidate", string(candidate)},
+		                {"mid", candidate.mid()}};
+
+		if (auto ws = wws.lock())
+			ws->send(message.dump());
+	});
+
+	return pc;
+}
+
+void sendUntilBuffered(shared_ptr<DataChannel> dc) {
+	try {
+		while (dc->isOpen() && dc->bufferedAmount() <= size_t(bufferSize))
+			dc->send(messageData);
+	} catch (const std::exception &e) {
+		std::cout << "Send failed: " << e.what() << std::endl;
+	}
+}
+
+// Value at rank p in [0, 1] of a sorted vector
+template <typename T> T percentile(const vector<T> &sorted, double p) {
+	if (sorted.empty())
+		return T{};
+
+	return sorted[std::min(sorted.size() - 1, size_t(p * double(sorted.size())))];
+}
+
 // Helper function to generate a random ID
 string randomId(size_t length) {
 	static const string characters(
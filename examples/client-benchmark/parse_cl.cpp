@@ -52,6 +52,7 @@ Cmdline::Cmdline(int argc, char *argv[]) // ISO C++17 not allowed: throw (std::s
 	                                       {"throughtputSetAsKB", required_argument, NULL, 'r'},
 	                                       {"bufferSize", required_argument, NULL, 'b'},
 										   {"dataChannelCount", required_argument, NULL, 'c'},
+	                                       {"peerPairs", required_argument, NULL, 'a'},
 	                                       {"help", no_argument, NULL, 'h'},
 	                                       {NULL, 0, NULL, 0}};
 
@@ -70,9 +71,10 @@ Cmdline::Cmdline(int argc, char *argv[]) // ISO C++17 not allowed: throw (std::s
 	_r = 300;
 	_b = 0;
 	_c = 1;
+	_a = 0;
 
 	optind = 0;
-	while ((c = getopt_long(argc, argv, "s:t:w:x:d:r:b:c:enhvop", long_options, &optind)) != -1) {
+	while ((c = getopt_long(argc, argv, "s:t:w:x:d:r:b:c:a:enhvop", long_options, &optind)) != -1) {
 		switch (c) {
 		case 'n':
 			_n = true;
@@ -158,6 +160,15 @@ Cmdline::Cmdline(int argc, char *argv[]) // ISO C++17 not allowed: throw (std::s
 			}
 			break;
 
+		case 'a':
+			_a = atoi(optarg);
+			if (_a < 0) {
+				std::string err;
+				err += "parameter range error: a must be >= 0";
+				throw(std::range_error(err));
+			}
+			break;
+
 		case 'h':
 			_h = true;
 			this->usage(EXIT_SUCCESS);
@@ -185,7 +196,7 @@ void Cmdline::usage(int status) {
 	else {
 		std::cout << "\
 usage: " << _program_name
-		          << " [ -enstwxdobprhv ] \n\
+		          << " [ -enstwxdobprcahv ] \n\
 libdatachannel client implementing WebRTC Data Channels with WebSocket signaling\n\
    [ -n ] [ --noStun ] (type=FLAG)\n\
           Do NOT use a stun server (overrides -s and -t).\n\
@@ -209,6 +220,8 @@ libdatachannel client implementing WebRTC Data Channels with WebSocket signaling
           Send constant data per second (KB).\n\
    [ -c ] [ --dataChannelCount ] (type=INTEGER, range>0...INT_MAX, default=1)\n\
           Dat Channel count to create.\n\
+   [ -a ] [ --peerPairs ] (type=INTEGER, range>=0...INT_MAX, default=0)\n\
+          Connect this many local peer pairs to each other and report statistics (load test).\n\
    [ -h ] [ --help ] (type=FLAG)\n\
           Display this help and exit.\n";
 	}
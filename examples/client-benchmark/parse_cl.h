@@ -46,6 +46,7 @@ private:
   int _r;
   int _b;
   int _c;
+  int _a;
 
   /* other stuff to keep track of */
   std::string _program_name;
@@ -74,6 +75,7 @@ public:
   bool enableThroughputSet () const { return _p; }
   int throughtputSetAsKB() const { return _r; }  
   int dataChannelCount() const { return _c; }
+  int peerPairs() const { return _a; }
 };
 
 #endif
@@ -67,7 +67,7 @@ int main() {
 
 		auto track = pc->addTrack(media);
 
-		auto session = std::make_shared<rtc::RtcpReceivingSession>();
+		auto session = std::make_shared<rtc::RtcpReceivingSession>(90000); // H264 clock rate
 		track->setMediaHandler(session);
 
 		track->onMessage(
@@ -59,7 +59,7 @@ int main() {
 		auto track = pc->addTrack(media);
 		pc->setLocalDescription();
 
-		auto session = std::make_shared<rtc::RtcpReceivingSession>();
+		auto session = std::make_shared<rtc::RtcpReceivingSession>(90000); // H264 clock rate
 		track->setMediaHandler(session);
 
 		const rtc::SSRC targetSSRC = 4;
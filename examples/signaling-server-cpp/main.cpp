@@ -0,0 +1,182 @@
+/**
+ * libdatachannel signaling server example
+ * Copyright (c) 2021 Paul-Louis Ageneau
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "rtc/rtc.hpp"
+
+#include <nlohmann/json.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
+using namespace rtc;
+using namespace std;
+using namespace std::chrono_literals;
+
+using json = nlohmann::json;
+
+template <class T> weak_ptr<T> make_weak_ptr(shared_ptr<T> ptr) { return ptr; }
+
+// Same protocol as the other signaling servers: clients connect to /<id> and send JSON messages
+// with an "id" field set to the destination, which is replaced with the source on forwarding.
+class SignalingServer {
+public:
+	SignalingServer(uint16_t port) : mServer(WebSocketServer::Configuration{port}) {
+		mServer.onClient([this](shared_ptr<WebSocket> ws) { accept(std::move(ws)); });
+	}
+
+	uint16_t port() const { return mServer.port(); }
+
+	size_t clientsCount() {
+		std::lock_guard lock(mMutex);
+		return mClients.size();
+	}
+
+	size_t forwardedCount() { return mForwardedCount.exchange(0); }
+	size_t droppedCount() { return mDroppedCount.exchange(0); }
+
+private:
+	void accept(shared_ptr<WebSocket> ws) {
+		// The path is only known once the WebSocket handshake is done, hold the client until then
+		auto id = std::make_shared<string>();
+		{
+			std::lock_guard lock(mMutex);
+			mPending.insert(ws);
+		}
+
+		ws->onOpen([this, id, wws = make_weak_ptr(ws)]() {
+			auto ws = wws.lock();
+			if (!ws)
+				return;
+
+			auto path = ws->path().value_or("");
+			auto pos = path.find_first_not_of('/');
+			if (pos == string::npos || path.find('/', pos) != string::npos) {
+				cerr << "Invalid path \"" << path << "\"" << endl;
+				ws->close(); // stays pending until closed
+				return;
+			}
+
+			*id = path.substr(pos);
+			shared_ptr<WebSocket> previous; // released outside the lock
+			std::lock_guard lock(mMutex);
+			mPending.erase(ws);
+			previous = std::exchange(mClients[*id], ws);
+		});
+
+		ws->onClosed([this, id, wws = make_weak_ptr(ws)]() { remove(*id, wws.lock()); });
+
+		ws->onError([this, id, wws = make_weak_ptr(ws)](string error) {
+			cerr << "Client " << *id << " error: " << error << endl;
+			remove(*id, wws.lock());
+		});
+
+		ws->onMessage([this, id](message_variant data) {
+			if (!holds_alternative<string>(data) || id->empty())
+				return;
+
+			try {
+				forward(*id, json::parse(get<string>(data)));
+			} catch (const std::exception &e) {
+				cerr << "Client " << *id << " sent an invalid message: " << e.what() << endl;
+			}
+		});
+	}
+
+	void remove(const string &id, shared_ptr<WebSocket> ws) {
+		if (!ws)
+			return;
+
+		std::lock_guard lock(mMutex);
+		mPending.erase(ws);
+		if (auto it = mClients.find(id); it != mClients.end() && it->second == ws)
+			mClients.erase(it);
+	}
+
+	void forward(const string &id, json message) {
+		auto it = message.find("id");
+		if (it == message.end())
+			return;
+
+		auto destination = it->get<string>();
+		*it = id;
+
+		shared_ptr<WebSocket> ws;
+		{
+			std::lock_guard lock(mMutex);
+			if (auto jt = mClients.find(destination); jt != mClients.end())
+				ws = jt->second;
+		}
+
+		if (!ws || !ws->isOpen()) {
+			++mDroppedCount;
+			return;
+		}
+
+		// Send outside the lock so one slow client does not stall the others
+		ws->send(message.dump());
+		++mForwardedCount;
+	}
+
+	std::mutex mMutex;
+	std::unordered_set<shared_ptr<WebSocket>> mPending; // handshake in progress
+	std::unordered_map<string, shared_ptr<WebSocket>> mClients;
+	std::atomic<size_t> mForwardedCount = 0;
+	std::atomic<size_t> mDroppedCount = 0;
+
+	WebSocketServer mServer; // destroyed first
+};
+
+int main(int argc, char **argv) try {
+	// Usage: signaling-server [port]
+	int port = argc > 1 ? atoi(argv[1]) : 8000;
+	if (port <= 0 || port > 65535) {
+		cerr << "Usage: " << argv[0] << " [port]" << endl;
+		return -1;
+	}
+
+	rtc::InitLogger(LogLevel::Warning);
+
+	SignalingServer server(static_cast<uint16_t>(port));
+	cout << "Listening on port " << server.port() << endl;
+
+	// Report activity every second, without logging each message so the server does not become
+	// the bottleneck of load tests
+	while (true) {
+		this_thread::sleep_for(1s);
+		size_t forwarded = server.forwardedCount();
+		size_t dropped = server.droppedCount();
+		if (forwarded > 0 || dropped > 0)
+			cout << "Clients: " << server.clientsCount() << "   Forwarded: " << forwarded
+			     << " msg/s   Dropped: " << dropped << " msg/s" << endl;
+	}
+
+	return 0;
+
+} catch (const std::exception &e) {
+	std::cout << "Error: " << e.what() << std::endl;
+	return -1;
+}
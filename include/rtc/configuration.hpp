@@ -83,6 +83,11 @@ struct RTC_CPP_EXPORT Configuration {
 	TransportPolicy iceTransportPolicy = TransportPolicy::All;
 	bool enableIceTcp = false;
 	bool disableAutoNegotiation = false;
+	bool pinToLoopThread = false; // process the connection on a single loop thread
+	bool enableSrtpNullCipher = false; // prefer authentication-only SRTP, not for browsers
+	bool enableParallelDataChannels = false; // run callbacks of distinct channels in parallel
+	bool enableInProcessTransport = false; // bypass UDP with a peer in the same process
+	bool enableBusyPolling = false; // receive with PeerConnection::poll() instead of callbacks
 
 	// Port range
 	uint16_t portRangeBegin = 1024;
@@ -0,0 +1,233 @@
+/**
+ * Copyright (c) 2021 Paul-Louis Ageneau
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef RTC_COROUTINE_H
+#define RTC_COROUTINE_H
+
+// Optional C++20 awaitables, header-only so the library itself stays C++17
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+
+#include "channel.hpp"
+#include "common.hpp"
+#include "datachannel.hpp"
+#include "peerconnection.hpp"
+
+#include <coroutine>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+
+namespace rtc::coro {
+
+// Resumes a coroutine, for instance by posting it to the user's event loop.
+// If null, the coroutine is resumed directly on the library thread.
+using executor = std::function<void(std::function<void()>)>;
+
+template <typename T> class awaitable {
+public:
+	struct state {
+		std::mutex mutex;
+		optional<T> value;
+		std::exception_ptr error;
+		std::coroutine_handle<> handle;
+		executor exec;
+
+		bool done() {
+			std::lock_guard lock(mutex);
+			return value || error;
+		}
+
+		void complete(T v) { finish(std::move(v), nullptr); }
+		void fail(std::exception_ptr e) { finish(nullopt, std::move(e)); }
+
+		// Sets the function resetting the callbacks once done, to be called after setting them
+		void onDone(std::function<void()> r) {
+			{
+				std::lock_guard lock(mutex);
+				if (!value && !error) {
+					release = std::move(r);
+					return;
+				}
+			}
+			r(); // completed in the meantime
+		}
+
+	private:
+		std::function<void()> release;
+
+		void finish(optional<T> v, std::exception_ptr e) {
+			std::coroutine_handle<> h;
+			std::function<void()> r;
+			{
+				std::lock_guard lock(mutex);
+				if (value || error)
+					return; // already done
+
+				value = std::move(v);
+				error = std::move(e);
+				h = std::exchange(handle, nullptr);
+				r = std::exchange(release, nullptr);
+			}
+
+			// The callbacks hold the state, resetting them also breaks the reference cycle
+			if (r)
+				r();
+
+			if (!h)
+				return;
+
+			if (exec)
+				exec([h]() { h.resume(); });
+			else
+				h.resume();
+		}
+	};
+
+	awaitable(shared_ptr<state> s) : mState(std::move(s)) {}
+
+	bool await_ready() const { return mState->done(); }
+
+	bool await_suspend(std::coroutine_handle<> h) {
+		std::lock_guard lock(mState->mutex);
+		if (mState->value || mState->error)
+			return false; // completed in the meantime
+
+		mState->handle = h;
+		return true;
+	}
+
+	T await_resume() {
+		std::lock_guard lock(mState->mutex);
+		if (mState->error)
+			std::rethrow_exception(mState->error);
+
+		return std::move(*mState->value);
+	}
+
+private:
+	shared_ptr<state> mState;
+};
+
+template <typename T> shared_ptr<typename awaitable<T>::state> make_state(executor exec) {
+	auto s = std::make_shared<typename awaitable<T>::state>();
+	s->exec = std::move(exec);
+	return s;
+}
+
+// The following functions take over the corresponding callbacks of the object: they replace the
+// callbacks set by the user, and reset them to none when the awaitable completes. Therefore,
+// callbacks must be set again after awaiting, and awaitables sharing a callback, like open() and
+// receive() with onClosed, must not be pending on the same object at the same time.
+
+// Completes when the PeerConnection is connected, throws if it fails or is closed
+inline awaitable<std::monostate> connected(shared_ptr<PeerConnection> pc, executor exec = nullptr) {
+	auto s = make_state<std::monostate>(std::move(exec));
+	pc->onStateChange([s](PeerConnection::State state) {
+		if (state == PeerConnection::State::Connected)
+			s->complete({});
+		else if (state == PeerConnection::State::Failed || state == PeerConnection::State::Closed)
+			s->fail(std::make_exception_ptr(std::runtime_error("PeerConnection failed")));
+	});
+	s->onDone([weak_pc = std::weak_ptr<PeerConnection>(pc)]() {
+		if (auto pc = weak_pc.lock())
+			pc->onStateChange(nullptr);
+	});
+	if (pc->state() == PeerConnection::State::Connected)
+		s->complete({});
+
+	return s;
+}
+
+// Completes when the DataChannel, Track or WebSocket is open, throws if it is closed
+inline awaitable<std::monostate> open(shared_ptr<Channel> channel, executor exec = nullptr) {
+	auto s = make_state<std::monostate>(std::move(exec));
+	channel->onOpen([s]() { s->complete({}); });
+	channel->onClosed(
+	    [s]() { s->fail(std::make_exception_ptr(std::runtime_error("Channel is closed"))); });
+	s->onDone([weak_channel = std::weak_ptr<Channel>(channel)]() {
+		if (auto channel = weak_channel.lock()) {
+			channel->onOpen(nullptr);
+			channel->onClosed(nullptr);
+		}
+	});
+	if (channel->isOpen())
+		s->complete({});
+	else if (channel->isClosed())
+		s->fail(std::make_exception_ptr(std::runtime_error("Channel is closed")));
+
+	return s;
+}
+
+// Completes with the next message, the channel must not have an onMessage callback
+inline awaitable<message_variant> receive(shared_ptr<Channel> channel, executor exec = nullptr) {
+	auto s = make_state<message_variant>(std::move(exec));
+	if (auto message = channel->receive()) {
+		s->complete(std::move(*message));
+		return s;
+	}
+
+	// Consume at most one message, even if called concurrently
+	auto poll = [s, weak_channel = std::weak_ptr<Channel>(channel),
+	             mutex = std::make_shared<std::mutex>()]() {
+		std::lock_guard lock(*mutex);
+		if (s->done())
+			return; // don't consume messages for the next receive
+
+		if (auto channel = weak_channel.lock())
+			if (auto message = channel->receive())
+				s->complete(std::move(*message));
+	};
+
+	channel->onAvailable(poll);
+	channel->onClosed(
+	    [s]() { s->fail(std::make_exception_ptr(std::runtime_error("Channel is closed"))); });
+	s->onDone([weak_channel = std::weak_ptr<Channel>(channel)]() {
+		if (auto channel = weak_channel.lock()) {
+			channel->onAvailable(nullptr);
+			channel->onClosed(nullptr);
+		}
+	});
+
+	poll(); // a message might have arrived before the callback was set
+	return s;
+}
+
+// Sends the message and completes when the buffered amount is low again
+inline awaitable<std::monostate> send(shared_ptr<Channel> channel, message_variant data,
+                                      executor exec = nullptr) {
+	auto s = make_state<std::monostate>(std::move(exec));
+	// Set the callback before sending so the low threshold crossing can't be missed
+	channel->onBufferedAmountLow([s]() { s->complete({}); });
+	s->onDone([weak_channel = std::weak_ptr<Channel>(channel)]() {
+		if (auto channel = weak_channel.lock())
+			channel->onBufferedAmountLow(nullptr);
+	});
+	try {
+		if (channel->send(std::move(data))) // false if buffered
+			s->complete({});
+	} catch (...) {
+		s->fail(std::current_exception());
+	}
+	return s;
+}
+
+} // namespace rtc::coro
+
+#endif
+
+#endif
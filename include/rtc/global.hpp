@@ -43,6 +43,12 @@ RTC_CPP_EXPORT void InitLogger(LogLevel level, LogCallback callback = nullptr);
 RTC_CPP_EXPORT void InitLogger(plog::Severity severity, plog::IAppender *appender = nullptr);
 #endif
 
+// Messages are formatted and written on a background thread instead of the logging thread, they
+// are dropped and counted if more than queueSize are pending. Replaces the current logger until
+// InitLogger() is called again, which restores synchronous logging.
+RTC_CPP_EXPORT void InitAsyncLogger(LogLevel level, LogCallback callback = nullptr,
+                                    size_t queueSize = 8192);
+
 RTC_CPP_EXPORT void Preload();
 RTC_CPP_EXPORT void Cleanup();
 
@@ -60,6 +66,7 @@ struct SctpSettings {
 	optional<std::chrono::milliseconds> initialRetransmitTimeout;
 	optional<unsigned int> maxRetransmitAttempts;
 	optional<std::chrono::milliseconds> heartbeatInterval;
+	optional<bool> zeroChecksum; // skip CRC32c with peers accepting it over DTLS
 };
 
 RTC_CPP_EXPORT void SetSctpSettings(SctpSettings s);
@@ -22,6 +22,7 @@
 #include "common.hpp"
 #include "reliability.hpp"
 
+#include <chrono>
 #include <functional>
 
 namespace rtc {
@@ -41,6 +42,8 @@ struct RTC_CPP_EXPORT Message : binary {
 	Type type;
 	unsigned int stream = 0; // Stream id (SCTP stream or SSRC)
 	unsigned int dscp = 0;   // Differentiated Services Code Point
+	bool retransmission = false; // Media packet sent again, scheduled after audio
+	std::chrono::steady_clock::time_point arrival = {}; // Reception time, zero if unknown
 	shared_ptr<Reliability> reliability;
 };
 
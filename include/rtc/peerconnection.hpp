@@ -94,6 +94,10 @@ public:
 	void addRemoteCandidate(Candidate candidate);
 
 	shared_ptr<DataChannel> createDataChannel(string label, DataChannelInit init = {});
+	// Creates one channel per label at once, with consecutive ids from init.id if set. With
+	// init.negotiated, channels open without any in-band handshake.
+	std::vector<shared_ptr<DataChannel>> createDataChannels(std::vector<string> labels,
+	                                                        DataChannelInit init = {});
 	void onDataChannel(std::function<void(std::shared_ptr<DataChannel> dataChannel)> callback);
 
 	shared_ptr<Track> addTrack(Description::Media description);
@@ -105,6 +109,11 @@ public:
 	void onGatheringStateChange(std::function<void(GatheringState state)> callback);
 	void onSignalingStateChange(std::function<void(SignalingState state)> callback);
 
+	// With Configuration::enableBusyPolling, processes pending incoming data on the calling thread
+	// without blocking, returns true if any was processed. Messages are then received on channels
+	// with receive(), as message callbacks are not called.
+	bool poll();
+
 	// Stats
 	void clearStats();
 	size_t bytesSent();
@@ -157,6 +157,11 @@ typedef struct {
 	rtcTransportPolicy iceTransportPolicy;
 	bool enableIceTcp;
 	bool disableAutoNegotiation;
+	bool pinToLoopThread;
+	bool enableSrtpNullCipher;
+	bool enableParallelDataChannels;
+	bool enableInProcessTransport;
+	bool enableBusyPolling;
 	uint16_t portRangeBegin; // 0 means automatic
 	uint16_t portRangeEnd;   // 0 means automatic
 	int mtu;                 // <= 0 means automatic
@@ -188,6 +193,8 @@ RTC_EXPORT int rtcGetRemoteAddress(int pc, char *buffer, int size);
 RTC_EXPORT int rtcGetSelectedCandidatePair(int pc, char *local, int localSize, char *remote,
                                            int remoteSize);
 
+RTC_EXPORT int rtcPoll(int pc); // returns 1 if data was processed, 0 otherwise
+
 // DataChannel, Track, and WebSocket common API
 
 RTC_EXPORT int rtcSetOpenCallback(int id, rtcOpenCallbackFunc cb);
@@ -396,6 +403,7 @@ typedef struct {
 	int initialRetransmitTimeoutMs; // in msecs, <= 0 means optimized default
 	int maxRetransmitAttempts;      // number of retransmissions, <= 0 means optimized default
 	int heartbeatIntervalMs;        // in msecs, <= 0 means optimized default
+	int zeroChecksum;               // 0 means optimized default (enabled), < 0 means disabled
 } rtcSctpSettings;
 
 // Note: SCTP settings apply to newly-created PeerConnections only
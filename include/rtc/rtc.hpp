@@ -27,6 +27,9 @@
 #include "peerconnection.hpp"
 #include "track.hpp"
 
+// C++20 awaitables, if available
+#include "coroutine.hpp"
+
 #if RTC_ENABLE_WEBSOCKET
 
 // WebSocket
@@ -42,6 +45,7 @@
 #include "rtcpnackresponder.hpp"
 #include "rtcpreceivingsession.hpp"
 #include "rtcpsrreporter.hpp"
+#include "rtpbridge.hpp"
 
 // Opus/h264 streaming
 #include "h264packetizationhandler.hpp"
@@ -32,6 +32,9 @@ namespace rtc {
 // An RtcpSession can be plugged into a Track to handle the whole RTCP session
 class RTC_CPP_EXPORT RtcpReceivingSession : public MediaHandler {
 public:
+	// The RTP clock rate of the stream is required to compute jitter, 0 disables it
+	RtcpReceivingSession(uint32_t clockRate = 0);
+
 	message_ptr incoming(message_ptr ptr) override;
 	message_ptr outgoing(message_ptr ptr) override;
 	bool send(message_ptr ptr);
@@ -46,10 +49,29 @@ protected:
 
 	void pushPLI();
 
+	// Interarrival jitter, see https://www.rfc-editor.org/rfc/rfc3550#appendix-A.8
+	void updateJitter(const RTP *rtp, std::chrono::steady_clock::time_point arrival);
+
+	// Feedback due at the same time is written in a single compound RTCP packet, which starts
+	// with an RR once media or an SR has been received
+	void pushFeedback(optional<unsigned int> lastSR_delay, optional<unsigned int> bitrate,
+	                  bool pli = false);
+
+	// Delay since the last SR in units of 1/65536 seconds, 0 if none
+	unsigned int lastSRDelay() const;
+
 	unsigned int mRequestedBitrate = 0;
 	SSRC mSsrc = 0;
 	uint32_t mGreatestSeqNo = 0;
-	uint64_t mSyncRTPTS, mSyncNTPTS;
+	uint64_t mSyncRTPTS = 0, mSyncNTPTS = 0;
+	optional<std::chrono::steady_clock::time_point> mLastSRArrival;
+
+	const uint32_t mClockRate;
+	SSRC mMediaSsrc = 0;
+	bool mHasSeqNo = false;
+	bool mHasTransit = false;
+	uint32_t mLastTransit = 0;
+	uint32_t mJitter = 0; // in RTP timestamp units, scaled by 16
 };
 
 } // namespace rtc
@@ -39,6 +39,8 @@ class RTC_CPP_EXPORT RtcpSrReporter final : public MediaHandlerElement {
 
 	void addToReport(RTP *rtp, uint32_t rtpSize);
 	message_ptr getSenderReport(uint32_t timestamp);
+	size_t senderReportSize() const;
+	void writeSenderReport(byte *data, uint32_t timestamp);
 
 public:
 	static uint64_t secondsToNTP(double seconds);
@@ -0,0 +1,79 @@
+/**
+ * Copyright (c) 2021 Paul-Louis Ageneau
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef RTC_RTP_BRIDGE_H
+#define RTC_RTP_BRIDGE_H
+
+#if RTC_ENABLE_MEDIA
+
+#include "common.hpp"
+#include "mediahandler.hpp"
+#include "rtp.hpp"
+
+namespace rtc {
+
+namespace impl {
+
+class RtpBridge;
+
+}
+
+// Bridges a Track with plain RTP over UDP, typically with a local GStreamer or ffmpeg pipeline.
+// Packets received on the local port are sent on the track, packets received on the track are
+// forwarded to the egress address if set. It replaces any other media handler on the track.
+class RTC_CPP_EXPORT RtpBridge final : public MediaHandler, private CheshireCat<impl::RtpBridge> {
+public:
+	struct Configuration {
+		uint16_t port = 0; // 0 means automatic
+		string bindAddress = "127.0.0.1";
+		optional<SSRC> ssrc;            // rewrite the SSRC of ingested packets
+		optional<uint8_t> payloadType; // rewrite the payload type of ingested RTP packets
+		optional<string> egressAddress; // forward packets received on the track
+		uint16_t egressPort = 0;
+		bool enableIoUring = false; // Linux only, falls back to recvmmsg if unsupported
+
+		// Linux only, receive with AF_XDP on the interface queue, bypassing the kernel network
+		// stack. Requires CAP_NET_ADMIN, CAP_NET_RAW, and CAP_BPF, falls back to the socket.
+		optional<string> xdpInterface;
+		unsigned int xdpQueue = 0; // traffic on other queues is received by the socket
+	};
+
+	// Receive paths, datagrams not redirected by AF_XDP are still received by the socket
+	enum class Backend { Socket, IoUring, Xdp };
+
+	RtpBridge(Configuration config);
+	~RtpBridge();
+
+	void stop();
+
+	uint16_t port() const;
+	Backend backend() const;                     // fastest path in use, after any fallback
+	size_t receivedCount(Backend backend) const; // datagrams received through the path
+
+	message_ptr incoming(message_ptr ptr) override;
+	message_ptr outgoing(message_ptr ptr) override;
+
+private:
+	using CheshireCat<impl::RtpBridge>::impl;
+};
+
+} // namespace rtc
+
+#endif // RTC_ENABLE_MEDIA
+
+#endif // RTC_RTP_BRIDGE_H
@@ -45,6 +45,9 @@ public:
 	void setDescription(Description::Media description);
 
 	void close(void) override;
+
+	// Media is sent in priority order, audio first. Returns true if sent or queued to be sent by
+	// another thread, false if dropped.
 	bool send(message_variant data) override;
 	bool send(const byte *data, size_t size) override;
 
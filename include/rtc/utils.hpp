@@ -19,12 +19,15 @@
 #ifndef RTC_UTILS_H
 #define RTC_UTILS_H
 
+#include <atomic>
 #include <functional>
 #include <memory>
 #include <mutex>
 #include <optional>
+#include <thread>
 #include <tuple>
 #include <utility>
+#include <vector>
 
 namespace rtc {
 
@@ -59,7 +62,34 @@ private:
 	std::function<void()> function;
 };
 
+// Invocation frame of a callback on the current thread, used to detect reentrant replacement
+struct callback_frame {
+	const void *owner;
+	callback_frame *prev;
+};
+
+// Callback invocation state of a thread
+struct callback_thread_state {
+	static const size_t HazardsCount = 8;
+
+	// Functions being invoked, replacement waits until they are cleared before deleting them
+	std::atomic<const void *> hazards[HazardsCount] = {};
+	size_t depth = 0;                 // hazards in use
+	callback_frame *frames = nullptr; // top of the invocation frame stack
+};
+
+// State of the current thread
+RTC_CPP_EXPORT callback_thread_state &thread_callback_state();
+
+// Wait until no thread publishes the function as a hazard anymore
+RTC_CPP_EXPORT void wait_callback_hazards(const void *func);
+
 // callback with built-in synchronization
+// The function is immutable and replaced atomically, so invocations from different threads run
+// concurrently without locking. Each thread publishes the function it invokes in its own hazard
+// slot, so invocations don't write to shared memory. Replacement waits for the previous function
+// to be cleared from the hazard slots of other threads, therefore once it returns the previous
+// function won't be called anymore.
 template <typename... Args> class synchronized_callback {
 public:
 	synchronized_callback() = default;
@@ -69,52 +99,180 @@ public:
 	virtual ~synchronized_callback() { *this = nullptr; }
 
 	synchronized_callback &operator=(synchronized_callback &&cb) {
-		std::scoped_lock lock(mutex, cb.mutex);
-		set(std::exchange(cb.callback, nullptr));
+		set(cb.take());
 		return *this;
 	}
 
 	synchronized_callback &operator=(const synchronized_callback &cb) {
-		std::scoped_lock lock(mutex, cb.mutex);
-		set(cb.callback);
+		set(cb.get());
 		return *this;
 	}
 
 	synchronized_callback &operator=(std::function<void(Args...)> func) {
-		std::lock_guard lock(mutex);
 		set(std::move(func));
 		return *this;
 	}
 
 	bool operator()(Args... args) const {
-		std::lock_guard lock(mutex);
-		return call(std::move(args)...);
+		invocation guard(this);
+		return call(guard.func(), std::move(args)...);
 	}
 
-	operator bool() const {
-		std::lock_guard lock(mutex);
-		return callback ? true : false;
-	}
+	operator bool() const { return mCallback.load() ? true : false; }
 
 	std::function<void(Args...)> wrap() const {
 		return [this](Args... args) { (*this)(std::move(args)...); };
 	}
 
 protected:
-	virtual void set(std::function<void(Args...)> func) { callback = std::move(func); }
-	virtual bool call(Args... args) const {
-		if (!callback)
+	using function = std::function<void(Args...)>;
+
+	virtual void set(function func) {
+		function *next = func ? new function(std::move(func)) : nullptr;
+		release(mCallback.exchange(next));
+	}
+
+	virtual bool call(const function *func, Args... args) const {
+		// func must be protected by an invocation guard
+		if (!func)
 			return false;
 
-		callback(std::move(args)...);
+		(*func)(std::move(args)...);
 		return true;
 	}
 
-	std::function<void(Args...)> callback;
-	mutable std::recursive_mutex mutex;
+private:
+	class invocation final {
+	public:
+		invocation(const synchronized_callback *cb) : mCb(cb), mState(thread_callback_state()) {
+			mFrame.owner = cb;
+			mFrame.prev = mState.frames;
+			mState.frames = &mFrame;
+			if (mState.depth < callback_thread_state::HazardsCount) {
+				// Publish the function, then check it has not been replaced meanwhile
+				mHazard = &mState.hazards[mState.depth++];
+				do {
+					mFunc = cb->mCallback.load();
+					mHazard->store(mFunc);
+				} while (cb->mCallback.load() != mFunc);
+			} else {
+				// Nested too deeply, count the invocation instead
+				mEpoch = cb->mEpoch.load() & 1;
+				++cb->mInvocations[mEpoch];
+				mFunc = cb->mCallback.load();
+			}
+		}
+
+		~invocation() {
+			if (mHazard) {
+				mHazard->store(nullptr, std::memory_order_release);
+				--mState.depth;
+			} else {
+				--mCb->mInvocations[mEpoch];
+			}
+			mState.frames = mFrame.prev;
+			if (mCb->mHasRetired && !mCb->invoking())
+				mCb->reclaim();
+		}
+
+		const function *func() const { return mFunc; }
+
+	private:
+		const synchronized_callback *mCb;
+		callback_thread_state &mState;
+		callback_frame mFrame;
+		std::atomic<const void *> *mHazard = nullptr;
+		const function *mFunc = nullptr;
+		unsigned int mEpoch = 0;
+	};
+
+	function get() const {
+		invocation guard(this);
+		const function *func = guard.func();
+		return func ? *func : nullptr;
+	}
+
+	function take() {
+		function *prev = mCallback.exchange(nullptr);
+		if (!prev)
+			return nullptr;
+
+		function func = *prev; // prev might still be running
+		release(prev);
+		return func;
+	}
+
+	bool invoking() const {
+		for (auto frame = thread_callback_state().frames; frame; frame = frame->prev)
+			if (frame->owner == this)
+				return true;
+
+		return false;
+	}
+
+	void release(function *prev) const {
+		if (invoking()) {
+			// We can't wait for ourselves, defer until the outermost invocation returns
+			if (prev) {
+				std::lock_guard lock(mRetiredMutex);
+				mRetired.emplace_back(prev);
+				mHasRetired = true;
+			}
+			return;
+		}
+
+		if (!prev && !mHasRetired)
+			return;
+
+		std::lock_guard lock(mWriteMutex);
+		auto retired = takeRetired();
+		if (prev)
+			retired.emplace_back(prev);
+
+		synchronize(retired);
+		for (auto func : retired)
+			delete func;
+	}
+
+	void reclaim() const {
+		std::lock_guard lock(mWriteMutex);
+		auto retired = takeRetired();
+		synchronize(retired);
+		for (auto func : retired)
+			delete func;
+	}
+
+	std::vector<function *> takeRetired() const {
+		std::lock_guard lock(mRetiredMutex);
+		mHasRetired = false;
+		return std::exchange(mRetired, {});
+	}
+
+	void synchronize(const std::vector<function *> &funcs) const {
+		// Requires mWriteMutex to be locked
+		for (auto func : funcs)
+			wait_callback_hazards(func);
+
+		// Wait for counted invocations started before the replacement to return. The epoch is
+		// flipped twice so invocations started meanwhile are counted separately and can't starve
+		// us.
+		for (int i = 0; i < 2; ++i) {
+			const unsigned int epoch = mEpoch.fetch_add(1) & 1;
+			while (mInvocations[epoch].load() != 0)
+				std::this_thread::yield();
+		}
+	}
+
+	std::atomic<function *> mCallback = nullptr;
+	mutable std::atomic<unsigned int> mEpoch = 0;
+	mutable std::atomic<unsigned int> mInvocations[2] = {0, 0};
+	mutable std::atomic<bool> mHasRetired = false;
+	mutable std::vector<function *> mRetired;
+	mutable std::mutex mRetiredMutex, mWriteMutex;
 };
 
 // callback with built-in synchronization and replay of the last missed call
+// Calls are serialized since the replay must not race with them.
 template <typename... Args>
 class synchronized_stored_callback final : public synchronized_callback<Args...> {
 public:
@@ -123,23 +281,31 @@ public:
 	    : synchronized_callback<Args...>(std::forward<CArgs>(cargs)...) {}
 	~synchronized_stored_callback() {}
 
+	template <typename T> synchronized_stored_callback &operator=(T &&t) {
+		synchronized_callback<Args...>::operator=(std::forward<T>(t));
+		return *this;
+	}
+
 private:
 	void set(std::function<void(Args...)> func) {
 		synchronized_callback<Args...>::set(func);
+		std::lock_guard lock(mutex);
 		if (func && stored) {
 			std::apply(func, std::move(*stored));
 			stored.reset();
 		}
 	}
 
-	bool call(Args... args) const {
-		if (!synchronized_callback<Args...>::call(args...))
+	bool call(const std::function<void(Args...)> *func, Args... args) const {
+		std::lock_guard lock(mutex);
+		if (!synchronized_callback<Args...>::call(func, args...))
 			stored.emplace(std::move(args)...);
 
 		return true;
 	}
 
 	mutable std::optional<std::tuple<Args...>> stored;
+	mutable std::recursive_mutex mutex;
 };
 
 // pimpl base class
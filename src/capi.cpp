@@ -344,6 +344,11 @@ int rtcCreatePeerConnection(const rtcConfiguration *config) {
 		c.iceTransportPolicy = static_cast<TransportPolicy>(config->iceTransportPolicy);
 		c.enableIceTcp = config->enableIceTcp;
 		c.disableAutoNegotiation = config->disableAutoNegotiation;
+		c.pinToLoopThread = config->pinToLoopThread;
+		c.enableSrtpNullCipher = config->enableSrtpNullCipher;
+		c.enableParallelDataChannels = config->enableParallelDataChannels;
+		c.enableInProcessTransport = config->enableInProcessTransport;
+		c.enableBusyPolling = config->enableBusyPolling;
 
 		if (config->mtu > 0)
 			c.mtu = size_t(config->mtu);
@@ -594,6 +599,13 @@ int rtcGetSelectedCandidatePair(int pc, char *local, int localSize, char *remote
 	});
 }
 
+int rtcPoll(int pc) {
+	return wrap([&] {
+		auto peerConnection = getPeerConnection(pc);
+		return peerConnection->poll() ? 1 : 0;
+	});
+}
+
 int rtcSetOpenCallback(int id, rtcOpenCallbackFunc cb) {
 	return wrap([&] {
 		auto channel = getChannel(id);
@@ -1382,6 +1394,11 @@ int rtcSetSctpSettings(const rtcSctpSettings *settings) {
 		if (settings->heartbeatIntervalMs > 0)
 			s.heartbeatInterval = std::chrono::milliseconds(settings->heartbeatIntervalMs);
 
+		if (settings->zeroChecksum > 0)
+			s.zeroChecksum = true;
+		else if (settings->zeroChecksum < 0)
+			s.zeroChecksum = false;
+
 		SetSctpSettings(std::move(s));
 		return RTC_ERR_SUCCESS;
 	});
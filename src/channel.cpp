@@ -29,7 +29,7 @@ Channel::Channel(impl_ptr<impl::Channel> impl) : CheshireCat<impl::Channel>(std:
 
 size_t Channel::maxMessageSize() const { return DEFAULT_MAX_MESSAGE_SIZE; }
 
-size_t Channel::bufferedAmount() const { return impl()->bufferedAmount; }
+size_t Channel::bufferedAmount() const { return impl()->bufferedAmount(); }
 
 void Channel::onOpen(std::function<void()> callback) { impl()->openCallback = callback; }
 
@@ -27,7 +27,13 @@
 
 #include "impl/init.hpp"
 
+#include <atomic>
+#include <condition_variable>
+#include <ctime>
+#include <iomanip>
 #include <mutex>
+#include <sstream>
+#include <thread>
 
 #ifdef _WIN32
 #include <codecvt>
@@ -36,6 +42,20 @@
 
 namespace rtc {
 
+namespace {
+
+std::string to_utf8(const plog::util::nstring &str) {
+#ifdef _WIN32
+	using convert_type = std::codecvt_utf8<wchar_t>;
+	std::wstring_convert<convert_type, wchar_t> converter;
+	return converter.to_bytes(str);
+#else
+	return str;
+#endif
+}
+
+} // namespace
+
 struct LogAppender : public plog::IAppender {
 	synchronized_callback<LogLevel, string> callback;
 
@@ -44,19 +64,225 @@ struct LogAppender : public plog::IAppender {
 		auto formatted = plog::FuncMessageFormatter::format(record);
 		formatted.pop_back(); // remove newline
 
-#ifdef _WIN32
-		using convert_type = std::codecvt_utf8<wchar_t>;
-		std::wstring_convert<convert_type, wchar_t> converter;
-		std::string str = converter.to_bytes(formatted);
-#else
-		std::string str = formatted;
-#endif
-
+		std::string str = to_utf8(formatted);
 		if (!callback(static_cast<LogLevel>(severity), str))
 			std::cout << plog::severityToString(severity) << " " << str << std::endl;
 	}
 };
 
+// Lock-free bounded queue of records, written out by a background thread
+class AsyncLogAppender final : public plog::IAppender {
+public:
+	AsyncLogAppender(size_t queueSize);
+	~AsyncLogAppender();
+
+	void write(const plog::Record &record) override;
+
+	synchronized_callback<LogLevel, string> callback;
+
+private:
+	struct Entry {
+		std::atomic<size_t> sequence;
+		plog::Severity severity;
+		plog::util::Time time;
+		unsigned int tid;
+		std::string func;
+		size_t line;
+		plog::util::nstring message;
+	};
+
+	bool pending() const; // true if the next record is ready, only called by the thread
+	bool writeOne();
+	void output(plog::Severity severity, const plog::util::Time &time, unsigned int tid,
+	            const std::string &location, const std::string &message);
+	void run();
+
+	const size_t mMask;
+	unique_ptr<Entry[]> mEntries;
+	std::atomic<size_t> mEnqueuePos = 0;
+	size_t mDequeuePos = 0; // only accessed by the thread
+	std::atomic<size_t> mDropped = 0;
+
+	std::atomic<bool> mStopping = false;
+	std::atomic<bool> mWaiting = false;
+	std::mutex mMutex;
+	std::condition_variable mCondition;
+	std::thread mThread;
+};
+
+AsyncLogAppender::AsyncLogAppender(size_t queueSize)
+    : mMask([queueSize]() {
+	      size_t size = 2;
+	      while (size < queueSize)
+		      size <<= 1;
+	      return size - 1;
+      }()),
+      mEntries(new Entry[mMask + 1]) {
+	for (size_t i = 0; i <= mMask; ++i)
+		mEntries[i].sequence.store(i, std::memory_order_relaxed);
+
+	mThread = std::thread(&AsyncLogAppender::run, this);
+}
+
+AsyncLogAppender::~AsyncLogAppender() {
+	{
+		std::lock_guard lock(mMutex);
+		mStopping = true;
+	}
+	mCondition.notify_all();
+	mThread.join();
+}
+
+void AsyncLogAppender::write(const plog::Record &record) {
+	// Claim a slot, see Vyukov's bounded MPMC queue
+	size_t pos = mEnqueuePos.load(std::memory_order_relaxed);
+	Entry *entry;
+	while (true) {
+		entry = &mEntries[pos & mMask];
+		size_t seq = entry->sequence.load(std::memory_order_acquire);
+		auto diff = static_cast<std::ptrdiff_t>(seq - pos);
+		if (diff == 0) {
+			if (mEnqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+				break;
+		} else if (diff < 0) {
+			// The queue is full, drop the record instead of blocking
+			mDropped.fetch_add(1, std::memory_order_relaxed);
+			return;
+		} else {
+			pos = mEnqueuePos.load(std::memory_order_relaxed);
+		}
+	}
+
+	// Only the message has been formatted by the caller, the rest is deferred to the thread
+	entry->severity = record.getSeverity();
+	entry->time = record.getTime();
+	entry->tid = record.getTid();
+	entry->func = record.getFunc();
+	entry->line = record.getLine();
+	entry->message = record.getMessage();
+
+	// Sequentially consistent with run(): either the thread sees the record before waiting, or the
+	// flag is seen here and the notification can't be lost as it is sent under the mutex
+	entry->sequence.store(pos + 1);
+	if (mWaiting.load()) {
+		std::lock_guard lock(mMutex);
+		mCondition.notify_one();
+	}
+}
+
+bool AsyncLogAppender::pending() const {
+	const Entry &entry = mEntries[mDequeuePos & mMask];
+	return entry.sequence.load() == mDequeuePos + 1; // sequentially consistent, see write()
+}
+
+bool AsyncLogAppender::writeOne() {
+	if (!pending())
+		return false; // empty
+
+	Entry &entry = mEntries[mDequeuePos & mMask];
+	std::string location = entry.func + "@" + std::to_string(entry.line);
+	output(entry.severity, entry.time, entry.tid, location, to_utf8(entry.message));
+
+	entry.message.clear();
+	entry.sequence.store(mDequeuePos + mMask + 1, std::memory_order_release);
+	++mDequeuePos;
+	return true;
+}
+
+void AsyncLogAppender::output(plog::Severity severity, const plog::util::Time &time,
+                              unsigned int tid, const std::string &location,
+                              const std::string &message) {
+	if (callback(static_cast<LogLevel>(severity), location + ": " + message))
+		return;
+
+	// Same layout as plog::TxtFormatter
+	tm t;
+	plog::util::localtime_s(&t, &time.time);
+	std::ostringstream ss;
+	ss << t.tm_year + 1900 << "-" << std::setfill('0') << std::setw(2) << t.tm_mon + 1 << "-"
+	   << std::setw(2) << t.tm_mday << " " << std::setw(2) << t.tm_hour << ":" << std::setw(2)
+	   << t.tm_min << ":" << std::setw(2) << t.tm_sec << "." << std::setw(3) << time.millitm
+	   << " " << std::setfill(' ') << std::setw(5) << std::left
+	   << plog::severityToString(severity) << " [" << tid << "] [" << location << "] " << message
+	   << "\n";
+	std::cout << ss.str() << std::flush;
+}
+
+void AsyncLogAppender::run() {
+	while (true) {
+		while (writeOne()) {
+		}
+
+		if (size_t dropped = mDropped.exchange(0, std::memory_order_relaxed)) {
+			plog::util::Time now;
+			plog::util::ftime(&now);
+			output(plog::warning, now, plog::util::gettid(), "AsyncLogAppender",
+			       "Log queue full, dropped " + std::to_string(dropped) + " messages");
+		}
+
+		std::unique_lock lock(mMutex);
+		if (mStopping) {
+			lock.unlock();
+			while (writeOne()) {
+			}
+			break;
+		}
+
+		// Sleep until write() or the destructor notifies, a full queue is never empty so dropped
+		// records always come with a pending one
+		mWaiting = true;
+		mCondition.wait(lock, [this]() { return mStopping || pending(); });
+		mWaiting = false;
+	}
+}
+
+namespace {
+
+// plog loggers can't remove appenders, so the logger writes to this one, which forwards records to
+// the main appender and allows to replace it
+class MainAppender final : public plog::IAppender {
+public:
+	void set(plog::IAppender *appender) { mAppender = appender; }
+
+	void write(const plog::Record &record) override {
+		if (auto appender = mAppender.load())
+			appender->write(record);
+	}
+
+private:
+	std::atomic<plog::IAppender *> mAppender = nullptr;
+};
+
+// Appenders are never destroyed, so replacing one can't race with a write. The asynchronous
+// appender replaces the synchronous one, which is restored by any other initialization.
+void InitLogger(plog::Severity severity, plog::IAppender *appender, bool async) {
+	static plog::ColorConsoleAppender<plog::TxtFormatter> consoleAppender;
+	static MainAppender mainAppender;
+	static plog::IAppender *syncAppender = nullptr;
+	static plog::Logger<0> *logger = nullptr;
+	static std::mutex mutex;
+	std::lock_guard lock(mutex);
+	if (async) {
+		mainAppender.set(appender);
+	} else if (!syncAppender) {
+		syncAppender = appender ? appender : &consoleAppender;
+		mainAppender.set(syncAppender);
+	} else {
+		mainAppender.set(syncAppender);
+		if (appender)
+			logger->addAppender(appender);
+	}
+
+	if (!logger) {
+		logger = &plog::init(severity, &mainAppender);
+		PLOG_DEBUG << "Logger initialized";
+	} else {
+		logger->setMaxSeverity(severity);
+	}
+}
+
+} // namespace
+
 void InitLogger(LogLevel level, LogCallback callback) {
 	static unique_ptr<LogAppender> appender;
 	const auto severity = static_cast<plog::Severity>(level);
@@ -72,19 +298,20 @@ void InitLogger(LogLevel level, LogCallback callback) {
 	}
 }
 
+void InitAsyncLogger(LogLevel level, LogCallback callback, size_t queueSize) {
+	static unique_ptr<AsyncLogAppender> appender;
+	const auto severity = static_cast<plog::Severity>(level);
+	if (!appender)
+		appender = std::make_unique<AsyncLogAppender>(queueSize);
+
+	appender->callback = std::move(callback);
+
+	// Replace the current appender, otherwise it would still write synchronously
+	InitLogger(severity, appender.get(), true);
+}
+
 void InitLogger(plog::Severity severity, plog::IAppender *appender) {
-	static plog::ColorConsoleAppender<plog::TxtFormatter> consoleAppender;
-	static plog::Logger<0> *logger = nullptr;
-	static std::mutex mutex;
-	std::lock_guard lock(mutex);
-	if (!logger) {
-		logger = &plog::init(severity, appender ? appender : &consoleAppender);
-		PLOG_DEBUG << "Logger initialized";
-	} else {
-		logger->setMaxSeverity(severity);
-		if (appender)
-			logger->addAppender(appender);
-	}
+	InitLogger(severity, appender, false);
 }
 
 void Preload() { Init::Preload(); }
@@ -38,7 +38,7 @@ void Channel::triggerAvailable(size_t count) {
 }
 
 void Channel::triggerBufferedAmount(size_t amount) {
-	size_t previous = bufferedAmount.exchange(amount);
+	size_t previous = mBufferedAmount.exchange(amount);
 	size_t threshold = bufferedAmountLowThreshold.load();
 	if (previous > threshold && amount <= threshold)
 		bufferedAmountLowCallback();
@@ -31,6 +31,7 @@ struct Channel {
 	virtual optional<message_variant> receive() = 0;
 	virtual optional<message_variant> peek() = 0;
 	virtual size_t availableAmount() const = 0;
+	virtual size_t bufferedAmount() const { return mBufferedAmount; }
 
 	virtual void triggerOpen();
 	virtual void triggerClosed();
@@ -50,11 +51,11 @@ struct Channel {
 
 	synchronized_callback<message_variant> messageCallback;
 
-	std::atomic<size_t> bufferedAmount = 0;
 	std::atomic<size_t> bufferedAmountLowThreshold = 0;
 
 private:
 	std::atomic<bool> mOpenTriggered = false;
+	std::atomic<size_t> mBufferedAmount = 0; // last triggered
 };
 
 } // namespace rtc::impl
@@ -0,0 +1,133 @@
+/**
+ * Copyright (c) 2021 Paul-Louis Ageneau
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "crc32c.hpp"
+
+#include <array>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define RTC_CRC32C_SSE42 1
+#include <nmmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#elif defined(__ARM_FEATURE_CRC32)
+#define RTC_CRC32C_ARM 1
+#include <arm_acle.h>
+#endif
+
+namespace rtc::impl {
+
+namespace {
+
+const uint32_t POLYNOMIAL = 0x82F63B78; // reversed Castagnoli polynomial
+
+std::array<uint32_t, 256> GenerateTable() {
+	std::array<uint32_t, 256> table;
+	for (uint32_t i = 0; i < 256; ++i) {
+		uint32_t crc = i;
+		for (int j = 0; j < 8; ++j)
+			crc = (crc >> 1) ^ (crc & 1 ? POLYNOMIAL : 0);
+
+		table[i] = crc;
+	}
+	return table;
+}
+
+uint32_t Crc32cSoftware(uint32_t crc, const std::byte *data, size_t size) {
+	static const auto table = GenerateTable();
+	for (size_t i = 0; i < size; ++i)
+		crc = table[(crc ^ std::to_integer<uint32_t>(data[i])) & 0xFF] ^ (crc >> 8);
+
+	return crc;
+}
+
+#if RTC_CRC32C_SSE42
+
+#if defined(__GNUC__) || defined(__clang__)
+__attribute__((target("sse4.2")))
+#endif
+uint32_t Crc32cHardware(uint32_t crc, const std::byte *data, size_t size) {
+#if defined(__x86_64__) || defined(_M_X64)
+	uint64_t crc64 = crc;
+	while (size >= 8) {
+		uint64_t word;
+		std::memcpy(&word, data, 8);
+		crc64 = _mm_crc32_u64(crc64, word);
+		data += 8;
+		size -= 8;
+	}
+	crc = uint32_t(crc64);
+#endif
+	while (size >= 4) {
+		uint32_t word;
+		std::memcpy(&word, data, 4);
+		crc = _mm_crc32_u32(crc, word);
+		data += 4;
+		size -= 4;
+	}
+	while (size--)
+		crc = _mm_crc32_u8(crc, std::to_integer<uint8_t>(*data++));
+
+	return crc;
+}
+
+bool HasHardwareSupport() {
+#ifdef _MSC_VER
+	int info[4];
+	__cpuid(info, 1);
+	return (info[2] & (1 << 20)) != 0; // SSE4.2
+#else
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("sse4.2");
+#endif
+}
+
+#elif RTC_CRC32C_ARM
+
+uint32_t Crc32cHardware(uint32_t crc, const std::byte *data, size_t size) {
+	while (size >= 8) {
+		uint64_t word;
+		std::memcpy(&word, data, 8);
+		crc = __crc32cd(crc, word);
+		data += 8;
+		size -= 8;
+	}
+	while (size--)
+		crc = __crc32cb(crc, std::to_integer<uint8_t>(*data++));
+
+	return crc;
+}
+
+bool HasHardwareSupport() { return true; } // checked at compile time
+
+#endif
+
+} // namespace
+
+uint32_t Crc32c(const std::byte *data, size_t size) {
+#if RTC_CRC32C_SSE42 || RTC_CRC32C_ARM
+	static const bool hardware = HasHardwareSupport();
+	if (hardware)
+		return ~Crc32cHardware(0xFFFFFFFF, data, size);
+#endif
+	return ~Crc32cSoftware(0xFFFFFFFF, data, size);
+}
+
+} // namespace rtc::impl
@@ -0,0 +1,34 @@
+/**
+ * Copyright (c) 2021 Paul-Louis Ageneau
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef RTC_IMPL_CRC32C_H
+#define RTC_IMPL_CRC32C_H
+
+// Standard headers only, so tests can use it
+#include <cstddef>
+#include <cstdint>
+
+namespace rtc::impl {
+
+// CRC32c (Castagnoli) as used by SCTP, see https://tools.ietf.org/html/rfc4960#appendix-B
+// Uses the SSE4.2 or ARMv8 CRC instructions when available.
+uint32_t Crc32c(const std::byte *data, size_t size);
+
+} // namespace rtc::impl
+
+#endif
@@ -75,6 +75,10 @@ struct CloseMessage {
 };
 #pragma pack(pop)
 
+static LogCounter COUNTER_POLL_QUEUE_FULL(plog::error,
+                                          "Number of DataChannel messages dropped due to a full "
+                                          "busy-polling queue despite backpressure");
+
 LogCounter COUNTER_USERNEG_OPEN_MESSAGE(
     plog::warning, "Number of open messages for a user-negotiated DataChannel received");
 
@@ -83,7 +87,19 @@ DataChannel::DataChannel(weak_ptr<PeerConnection> pc, uint16_t stream, string la
     : mPeerConnection(pc), mStream(stream), mLabel(std::move(label)),
       mProtocol(std::move(protocol)),
       mReliability(std::make_shared<Reliability>(std::move(reliability))),
-      mRecvQueue(RECV_QUEUE_LIMIT, message_size_func) {}
+      mRecvQueue(RECV_QUEUE_LIMIT, message_size_func) {
+
+	if (auto locked = pc.lock()) {
+		if (locked->config.enableParallelDataChannels)
+			mDispatchPool = &locked->pool();
+
+		if (locked->config.enableBusyPolling) {
+			mPollQueue =
+			    std::make_unique<Ring<message_ptr>>(BUSY_POLLING_QUEUE_LIMIT, message_size_func);
+			mFullPollQueuesCount = locked->fullPollQueuesCount;
+		}
+	}
+}
 
 DataChannel::~DataChannel() { close(); }
 
@@ -98,6 +114,9 @@ void DataChannel::close() {
 	if (mIsOpen.exchange(false) && transport)
 		transport->closeStream(mStream);
 
+	if (mPollQueue)
+		updatePollQueueFull(); // a closed channel must not stop polling
+
 	resetCallbacks();
 }
 
@@ -109,7 +128,10 @@ void DataChannel::remoteClose() {
 }
 
 optional<message_variant> DataChannel::receive() {
-	while (auto next = mRecvQueue.tryPop()) {
+	while (auto next = mPollQueue ? mPollQueue->pop() : mRecvQueue.tryPop()) {
+		if (mPollQueue)
+			updatePollQueueFull();
+
 		message_ptr message = *next;
 		if (message->type != Message::Control)
 			return to_variant(std::move(*message));
@@ -123,7 +145,7 @@ optional<message_variant> DataChannel::receive() {
 }
 
 optional<message_variant> DataChannel::peek() {
-	while (auto next = mRecvQueue.peek()) {
+	while (auto next = mPollQueue ? mPollQueue->peek() : mRecvQueue.peek()) {
 		message_ptr message = *next;
 		if (message->type != Message::Control)
 			return to_variant(std::move(*message));
@@ -132,13 +154,27 @@ optional<message_variant> DataChannel::peek() {
 		if (!message->empty() && raw[0] == MESSAGE_CLOSE)
 			remoteClose();
 
-		mRecvQueue.tryPop();
+		if (mPollQueue) {
+			mPollQueue->pop();
+			updatePollQueueFull();
+		} else {
+			mRecvQueue.tryPop();
+		}
 	}
 
 	return nullopt;
 }
 
-size_t DataChannel::availableAmount() const { return mRecvQueue.amount(); }
+size_t DataChannel::availableAmount() const {
+	return mPollQueue ? mPollQueue->amount() : mRecvQueue.amount();
+}
+
+size_t DataChannel::bufferedAmount() const {
+	// Read the current value from the transport, callbacks are asynchronous
+	std::shared_lock lock(mMutex);
+	auto transport = mSctpTransport.lock();
+	return transport ? transport->bufferedAmount(mStream) : Channel::bufferedAmount();
+}
 
 uint16_t DataChannel::stream() const {
 	std::shared_lock lock(mMutex);
@@ -202,8 +238,11 @@ bool DataChannel::outgoing(message_ptr message) {
 		if (message->size() > maxMessageSize())
 			throw std::runtime_error("Message size exceeds limit");
 
-		// Before the ACK has been received on a DataChannel, all messages must be sent ordered
-		message->reliability = mIsOpen ? mReliability : nullptr;
+		// Before the ACK has been received on a DataChannel, all messages must be sent ordered.
+		// No reliability means reliable and ordered, so skip the reference in that case.
+		const bool isDefault =
+		    !mReliability->unordered && mReliability->type == Reliability::Type::Reliable;
+		message->reliability = mIsOpen && !isDefault ? mReliability : nullptr;
 		message->stream = mStream;
 	}
 
@@ -230,8 +269,7 @@ void DataChannel::incoming(message_ptr message) {
 			break;
 		case MESSAGE_CLOSE:
 			// The close message will be processed in-order in receive()
-			mRecvQueue.push(message);
-			triggerAvailable(mRecvQueue.size());
+			queueIncoming(message);
 			break;
 		default:
 			// Ignore
@@ -241,8 +279,7 @@ void DataChannel::incoming(message_ptr message) {
 	}
 	case Message::String:
 	case Message::Binary:
-		mRecvQueue.push(message);
-		triggerAvailable(mRecvQueue.size());
+		queueIncoming(message);
 		break;
 	default:
 		// Ignore
@@ -250,6 +287,59 @@ void DataChannel::incoming(message_ptr message) {
 	}
 }
 
+void DataChannel::queueIncoming(message_ptr message) {
+	// In busy-polling mode, the application receives without any callback
+	if (mPollQueue) {
+		// Not expected, as PeerConnection::poll() stops receiving while the queue is full
+		if (!mPollQueue->push(message))
+			COUNTER_POLL_QUEUE_FULL++;
+
+		updatePollQueueFull();
+		return;
+	}
+
+	mRecvQueue.push(message);
+	size_t count = mRecvQueue.size();
+	if (!mDispatchPool) {
+		triggerAvailable(count);
+		return;
+	}
+
+	// Only one task runs at a time for the channel, so callbacks stay in order
+	if (count == 1)
+		mAvailablePending = true;
+
+	if (mDispatchCount++ == 0)
+		mDispatchPool->enqueue([weak_this = weak_from_this()]() {
+			if (auto locked = weak_this.lock())
+				locked->dispatchAvailable();
+		});
+}
+
+void DataChannel::updatePollQueueFull() {
+	// Called by the polling thread after a push and by the application after a pop. The flag is
+	// checked again after being written, so whichever thread runs last leaves it matching the
+	// queue, and the count of the connection only changes when the flag does.
+	while (true) {
+		std::atomic_thread_fence(std::memory_order_seq_cst); // pairs with the other thread
+		bool full = !mIsClosed && mPollQueue->full();
+		if (mPollQueueFull.load() == full)
+			break;
+
+		if (mPollQueueFull.exchange(full) != full)
+			*mFullPollQueuesCount += full ? 1 : -1;
+	}
+}
+
+void DataChannel::dispatchAvailable() {
+	int count;
+	do {
+		count = mDispatchCount.load();
+		// A count of 1 means the queue was empty, which triggers the available callback
+		triggerAvailable(mAvailablePending.exchange(false) ? 1 : 0);
+	} while ((mDispatchCount -= count) > 0); // loop if notified in the meantime
+}
+
 NegotiatedDataChannel::NegotiatedDataChannel(weak_ptr<PeerConnection> pc, uint16_t stream,
                                              string label, string protocol, Reliability reliability)
     : DataChannel(pc, stream, std::move(label), std::move(protocol), std::move(reliability)) {}
@@ -329,20 +419,23 @@ void NegotiatedDataChannel::processOpenMessage(message_ptr message) {
 	mLabel.assign(end, open.labelLength);
 	mProtocol.assign(end + open.labelLength, open.protocolLength);
 
-	mReliability->unordered = (open.channelType & 0x80) != 0;
+	// Replace instead of modifying as queued messages share the reliability
+	Reliability reliability;
+	reliability.unordered = (open.channelType & 0x80) != 0;
 	switch (open.channelType & 0x7F) {
 	case CHANNEL_PARTIAL_RELIABLE_REXMIT:
-		mReliability->type = Reliability::Type::Rexmit;
-		mReliability->rexmit = int(open.reliabilityParameter);
+		reliability.type = Reliability::Type::Rexmit;
+		reliability.rexmit = int(open.reliabilityParameter);
 		break;
 	case CHANNEL_PARTIAL_RELIABLE_TIMED:
-		mReliability->type = Reliability::Type::Timed;
-		mReliability->rexmit = milliseconds(open.reliabilityParameter);
+		reliability.type = Reliability::Type::Timed;
+		reliability.rexmit = milliseconds(open.reliabilityParameter);
 		break;
 	default:
-		mReliability->type = Reliability::Type::Reliable;
-		mReliability->rexmit = int(0);
+		reliability.type = Reliability::Type::Reliable;
+		reliability.rexmit = int(0);
 	}
+	mReliability = std::make_shared<Reliability>(std::move(reliability));
 
 	lock.unlock();
 
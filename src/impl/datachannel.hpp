@@ -24,6 +24,7 @@
 #include "message.hpp"
 #include "peerconnection.hpp"
 #include "queue.hpp"
+#include "ring.hpp"
 #include "reliability.hpp"
 #include "sctptransport.hpp"
 
@@ -47,6 +48,7 @@ struct DataChannel : Channel, std::enable_shared_from_this<DataChannel> {
 	optional<message_variant> receive() override;
 	optional<message_variant> peek() override;
 	size_t availableAmount() const override;
+	size_t bufferedAmount() const override;
 
 	uint16_t stream() const;
 	string label() const;
@@ -63,6 +65,10 @@ struct DataChannel : Channel, std::enable_shared_from_this<DataChannel> {
 	virtual void processOpenMessage(message_ptr);
 
 protected:
+	void queueIncoming(message_ptr message);
+	void dispatchAvailable();
+	void updatePollQueueFull();
+
 	const weak_ptr<impl::PeerConnection> mPeerConnection;
 	weak_ptr<SctpTransport> mSctpTransport;
 
@@ -74,9 +80,17 @@ protected:
 	mutable std::shared_mutex mMutex;
 
 	Queue<message_ptr> mRecvQueue;
+	std::unique_ptr<Ring<message_ptr>> mPollQueue; // replaces mRecvQueue in busy-polling mode
+	shared_ptr<std::atomic<int>> mFullPollQueuesCount; // of the connection
+	std::atomic<bool> mPollQueueFull = false;          // counted in mFullPollQueuesCount
 
 	std::atomic<bool> mIsOpen = false;
 	std::atomic<bool> mIsClosed = false;
+
+	// If set, callbacks are dispatched on the pool instead of the receiving thread
+	ThreadPool *mDispatchPool = nullptr;
+	std::atomic<int> mDispatchCount = 0; // pending notifications, a task runs while positive
+	std::atomic<bool> mAvailablePending = false; // the queue was empty before a notification
 };
 
 struct NegotiatedDataChannel final : public DataChannel {
@@ -19,6 +19,7 @@
 #include "dtlssrtptransport.hpp"
 #include "logcounter.hpp"
 #include "rtp.hpp"
+#include "threadpool.hpp"
 #include "tls.hpp"
 
 #if RTC_ENABLE_MEDIA
@@ -50,6 +51,13 @@ static LogCounter
 static LogCounter
     COUNTER_SRTP_FAIL(plog::warning,
                       "Number of SRTP packets received that had an unknown libSRTP failure");
+static LogCounter COUNTER_MEDIA_QUEUE_FULL(plog::warning,
+                                           "Number of media packets dropped due to a full queue");
+static LogCounter COUNTER_MEDIA_SEND_FAIL(plog::warning,
+                                          "Number of media packets that failed to be sent");
+static LogCounter
+    COUNTER_SRTP_SESSIONS_FULL(plog::warning,
+                               "Number of SRT(C)P packets dropped due to too many SSRCs");
 
 void DtlsSrtpTransport::Init() { srtp_init(); }
 
@@ -59,31 +67,25 @@ DtlsSrtpTransport::DtlsSrtpTransport(shared_ptr<IceTransport> lower,
                                      shared_ptr<Certificate> certificate, optional<size_t> mtu,
                                      verifier_callback verifierCallback,
                                      message_callback srtpRecvCallback,
-                                     state_callback stateChangeCallback)
+                                     state_callback stateChangeCallback, bool srtpNullCipher)
     : DtlsTransport(lower, certificate, mtu, std::move(verifierCallback),
-                    std::move(stateChangeCallback)),
+                    std::move(stateChangeCallback), srtpNullCipher),
       mSrtpRecvCallback(std::move(srtpRecvCallback)) { // distinct from Transport recv callback
 
 	PLOG_DEBUG << "Initializing DTLS-SRTP transport";
-
-	if (srtp_err_status_t err = srtp_create(&mSrtpIn, nullptr)) {
-		throw std::runtime_error("SRTP create failed, status=" + to_string(static_cast<int>(err)));
-	}
-	if (srtp_err_status_t err = srtp_create(&mSrtpOut, nullptr)) {
-		srtp_dealloc(mSrtpIn);
-		throw std::runtime_error("SRTP create failed, status=" + to_string(static_cast<int>(err)));
-	}
 }
 
 DtlsSrtpTransport::~DtlsSrtpTransport() {
 	stop(); // stop before deallocating
 
-	srtp_dealloc(mSrtpIn);
-	srtp_dealloc(mSrtpOut);
+	for (auto &[ssrc, session] : mSrtpIn)
+		srtp_dealloc(session);
+
+	for (auto &[ssrc, session] : mSrtpOut)
+		srtp_dealloc(session);
 }
 
-bool DtlsSrtpTransport::sendMedia(message_ptr message) {
-	std::lock_guard lock(sendMutex);
+bool DtlsSrtpTransport::sendMedia(message_ptr message, Priority priority) {
 	if (!message)
 		return false;
 
@@ -92,14 +94,114 @@ bool DtlsSrtpTransport::sendMedia(message_ptr message) {
 		return false;
 	}
 
-	int size = int(message->size());
-	PLOG_VERBOSE << "Send size=" << size;
-
 	// The RTP header has a minimum size of 12 bytes
 	// An RTCP packet can have a minimum size of 8 bytes
+	size_t size = message->size();
 	if (size < 8)
 		throw std::runtime_error("RTP/RTCP packet too short");
 
+	uint8_t value2 = to_integer<uint8_t>(*(message->begin() + 1)) & 0x7F;
+	if (!(value2 >= 64 && value2 <= 95) && size < 12) // See RFC 5761 reference below
+		throw std::runtime_error("RTP packet too short");
+
+	const Message *own = message.get();
+	{
+		std::lock_guard lock(mSendQueuesMutex);
+		auto &queue = mSendQueues[static_cast<int>(priority)];
+		if (queue.size() >= MEDIA_SEND_QUEUE_LIMIT) {
+			COUNTER_MEDIA_QUEUE_FULL++;
+			return false;
+		}
+
+		queue.push_back(std::move(message));
+		if (mSending)
+			return true; // the sending thread will pick it up in priority order
+
+		mSending = true;
+	}
+
+	return drainMedia(own);
+}
+
+void DtlsSrtpTransport::releaseSessions(const std::vector<uint32_t> &ssrcs) {
+	if (ssrcs.empty())
+		return;
+
+	std::lock_guard lock(mReleasedMutex);
+	mReleasedIn.insert(mReleasedIn.end(), ssrcs.begin(), ssrcs.end());
+	mReleasedOut.insert(mReleasedOut.end(), ssrcs.begin(), ssrcs.end());
+	mHasReleasedIn = true;
+	mHasReleasedOut = true;
+}
+
+bool DtlsSrtpTransport::drainMedia(const Message *own) {
+	// Send in priority order, picking the highest priority message each time, so audio from other
+	// threads is not stuck behind a video burst. The calling thread sends at most
+	// MEDIA_SEND_BATCH_SIZE messages, then the thread pool continues, so a thread sending audio
+	// does not keep sending the video other threads queue meanwhile.
+	bool result = true; // still queued counts as sent, like when another thread is sending
+	std::exception_ptr error;
+	bool empty = false;
+	for (size_t count = 0; count < MEDIA_SEND_BATCH_SIZE; ++count) {
+		auto next = dequeueMedia();
+		if (!next) {
+			empty = true;
+			break;
+		}
+
+		bool isOwn = next.get() == own;
+		if (isOwn)
+			own = nullptr; // the address might be reused once sent
+
+		try {
+			bool sent = protectMedia(std::move(next));
+			if (isOwn)
+				result = sent;
+		} catch (const std::exception &e) {
+			if (isOwn) {
+				error = std::current_exception(); // thrown once done sending
+				continue;
+			}
+			PLOG_DEBUG << e.what();
+			COUNTER_MEDIA_SEND_FAIL++;
+		}
+	}
+
+	if (!empty) {
+		// Still sending, so no other thread will pick up the remaining messages
+		ThreadPool::Instance().enqueue([weak_this = weak_from_this()]() {
+			if (auto shared_this = weak_this.lock())
+				shared_this->drainMedia(nullptr);
+		});
+	}
+
+	if (error)
+		std::rethrow_exception(error);
+
+	return result;
+}
+
+message_ptr DtlsSrtpTransport::dequeueMedia() {
+	std::lock_guard lock(mSendQueuesMutex);
+	for (auto &queue : mSendQueues) {
+		if (!queue.empty()) {
+			auto message = std::move(queue.front());
+			queue.pop_front();
+			return message;
+		}
+	}
+
+	mSending = false;
+	return nullptr;
+}
+
+bool DtlsSrtpTransport::protectMedia(message_ptr message) {
+	// Called by one thread at a time, see sendMedia()
+	eraseReleasedSessions(mSrtpOut, mReleasedOut, mHasReleasedOut);
+
+	int size = int(message->size());
+	PLOG_VERBOSE << "Send size=" << size;
+
 	// srtp_protect() and srtp_protect_rtcp() assume that they can write SRTP_MAX_TRAILER_LEN (for
 	// the authentication tag) into the location in memory immediately following the RTP packet.
 	message->resize(size + SRTP_MAX_TRAILER_LEN);
@@ -116,7 +218,9 @@ bool DtlsSrtpTransport::sendMedia(message_ptr message) {
 	// the range 96-127 where possible. Values below 64 MAY be used if that is insufficient
 	// [...]
 	if (value2 >= 64 && value2 <= 95) { // Range 64-95 (inclusive) MUST be RTCP
-		if (srtp_err_status_t err = srtp_protect_rtcp(mSrtpOut, message->data(), &size)) {
+		uint32_t ssrc = reinterpret_cast<RTCP_SR *>(message->data())->senderSSRC();
+		srtp_t session = getSession(mSrtpOut, mOutboundPolicy, ssrc);
+		if (srtp_err_status_t err = srtp_protect_rtcp(session, message->data(), &size)) {
 			if (err == srtp_err_status_replay_fail)
 				throw std::runtime_error("Outgoing SRTCP packet is a replay");
 			else
@@ -125,7 +229,9 @@ bool DtlsSrtpTransport::sendMedia(message_ptr message) {
 		}
 		PLOG_VERBOSE << "Protected SRTCP packet, size=" << size;
 	} else {
-		if (srtp_err_status_t err = srtp_protect(mSrtpOut, message->data(), &size)) {
+		uint32_t ssrc = reinterpret_cast<RTP *>(message->data())->ssrc();
+		srtp_t session = getSession(mSrtpOut, mOutboundPolicy, ssrc);
+		if (srtp_err_status_t err = srtp_protect(session, message->data(), &size)) {
 			if (err == srtp_err_status_replay_fail)
 				throw std::runtime_error("Outgoing SRTP packet is a replay");
 			else
@@ -171,6 +277,8 @@ void DtlsSrtpTransport::incoming(message_ptr message) {
 		DtlsTransport::incoming(message);
 
 	} else if (value1 >= 128 && value1 <= 191) {
+		eraseReleasedSessions(mSrtpIn, mReleasedIn, mHasReleasedIn);
+
 		// The RTP header has a minimum size of 12 bytes
 		// An RTCP packet can have a minimum size of 8 bytes
 		if (size < 8) {
@@ -186,7 +294,18 @@ void DtlsSrtpTransport::incoming(message_ptr message) {
 		// See RFC 5761 reference above
 		if (value2 >= 64 && value2 <= 95) { // Range 64-95 (inclusive) MUST be RTCP
 			PLOG_VERBOSE << "Incoming SRTCP packet, size=" << size;
-			if (srtp_err_status_t err = srtp_unprotect_rtcp(mSrtpIn, message->data(), &size)) {
+			uint32_t ssrc = reinterpret_cast<RTCP_SR *>(message->data())->senderSSRC();
+			bool known = mSrtpIn.find(ssrc) != mSrtpIn.end();
+			if (!known && mSrtpIn.size() >= SRTP_MAX_INBOUND_SESSIONS) {
+				COUNTER_SRTP_SESSIONS_FULL++;
+				PLOG_VERBOSE << "Too many inbound SRTP sessions, dropping SRTCP packet";
+				return;
+			}
+			srtp_t session = getSession(mSrtpIn, mInboundPolicy, ssrc);
+			if (srtp_err_status_t err = srtp_unprotect_rtcp(session, message->data(), &size)) {
+				if (!known)
+					eraseSession(mSrtpIn, ssrc); // don't keep sessions for forged packets
+
 				if (err == srtp_err_status_replay_fail) {
 					PLOG_VERBOSE << "Incoming SRTCP packet is a replay";
 					COUNTER_SRTCP_REPLAY++;
@@ -202,11 +321,28 @@ void DtlsSrtpTransport::incoming(message_ptr message) {
 			}
 			PLOG_VERBOSE << "Unprotected SRTCP packet, size=" << size;
 			message->type = Message::Type::Control;
-			message->stream = reinterpret_cast<RTCP_SR *>(message->data())->senderSSRC();
+			message->stream = ssrc;
 
 		} else {
 			PLOG_VERBOSE << "Incoming SRTP packet, size=" << size;
-			if (srtp_err_status_t err = srtp_unprotect(mSrtpIn, message->data(), &size)) {
+			if (size < 12) {
+				COUNTER_MEDIA_TRUNCATED++;
+				PLOG_VERBOSE << "Incoming SRTP packet too short, size=" << size;
+				return;
+			}
+
+			uint32_t ssrc = reinterpret_cast<RTP *>(message->data())->ssrc();
+			bool known = mSrtpIn.find(ssrc) != mSrtpIn.end();
+			if (!known && mSrtpIn.size() >= SRTP_MAX_INBOUND_SESSIONS) {
+				COUNTER_SRTP_SESSIONS_FULL++;
+				PLOG_VERBOSE << "Too many inbound SRTP sessions, dropping SRTP packet";
+				return;
+			}
+			srtp_t session = getSession(mSrtpIn, mInboundPolicy, ssrc);
+			if (srtp_err_status_t err = srtp_unprotect(session, message->data(), &size)) {
+				if (!known)
+					eraseSession(mSrtpIn, ssrc); // don't keep sessions for forged packets
+
 				if (err == srtp_err_status_replay_fail) {
 					PLOG_VERBOSE << "Incoming SRTP packet is a replay";
 					COUNTER_SRTP_REPLAY++;
@@ -221,7 +357,7 @@ void DtlsSrtpTransport::incoming(message_ptr message) {
 			}
 			PLOG_VERBOSE << "Unprotected SRTP packet, size=" << size;
 			message->type = Message::Type::Binary;
-			message->stream = reinterpret_cast<RTP *>(message->data())->ssrc();
+			message->stream = ssrc;
 		}
 
 		message->resize(size);
@@ -242,10 +378,16 @@ void DtlsSrtpTransport::postHandshake() {
 	const size_t materialLen = SRTP_AES_ICM_128_KEY_LEN_WSALT * 2;
 	unsigned char material[materialLen];
 	const unsigned char *clientKey, *clientSalt, *serverKey, *serverSalt;
+	bool nullCipher; // authentication only
 
 #if USE_GNUTLS
 	PLOG_INFO << "Deriving SRTP keying material (GnuTLS)";
 
+	gnutls_srtp_profile_t profile;
+	gnutls::check(gnutls_srtp_get_selected_profile(mSession, &profile),
+	              "Failed to get SRTP profile");
+	nullCipher = profile == GNUTLS_SRTP_NULL_HMAC_SHA1_80;
+
 	gnutls_datum_t clientKeyDatum, clientSaltDatum, serverKeyDatum, serverSaltDatum;
 	gnutls::check(gnutls_srtp_get_keys(mSession, material, materialLen, &clientKeyDatum,
 	                                   &clientSaltDatum, &serverKeyDatum, &serverSaltDatum),
@@ -270,6 +412,12 @@ void DtlsSrtpTransport::postHandshake() {
 #else
 	PLOG_INFO << "Deriving SRTP keying material (OpenSSL)";
 
+	const SRTP_PROTECTION_PROFILE *profile = SSL_get_selected_srtp_profile(mSsl);
+	if (!profile)
+		throw std::runtime_error("Failed to get SRTP profile: " +
+		                         openssl::error_string(ERR_get_error()));
+	nullCipher = profile->id == SRTP_NULL_SHA1_80;
+
 	// The extractor provides the client write master key, the server write master key, the client
 	// write master salt and the server write master salt in that order.
 	const string label = "EXTRACTOR-dtls_srtp";
@@ -293,35 +441,79 @@ void DtlsSrtpTransport::postHandshake() {
 	std::memcpy(mServerSessionKey, serverKey, SRTP_AES_128_KEY_LEN);
 	std::memcpy(mServerSessionKey + SRTP_AES_128_KEY_LEN, serverSalt, SRTP_SALT_LEN);
 
-	srtp_policy_t inbound = {};
-	srtp_crypto_policy_set_aes_cm_128_hmac_sha1_80(&inbound.rtp);
-	srtp_crypto_policy_set_aes_cm_128_hmac_sha1_80(&inbound.rtcp);
-	inbound.ssrc.type = ssrc_any_inbound;
+	// With the null cipher, packets are only authenticated, so forwarding them costs one HMAC per
+	// hop instead of decrypting and encrypting the payload. Keying material has the same layout.
+	auto setCryptoPolicy = nullCipher ? srtp_crypto_policy_set_null_cipher_hmac_sha1_80
+	                                  : srtp_crypto_policy_set_aes_cm_128_hmac_sha1_80;
+	if (nullCipher)
+		PLOG_INFO << "Using SRTP null cipher, media is authenticated but not encrypted";
+
+	// Sessions are created per SSRC from those policies
+	srtp_policy_t &inbound = mInboundPolicy;
+	setCryptoPolicy(&inbound.rtp);
+	setCryptoPolicy(&inbound.rtcp);
+	inbound.ssrc.type = ssrc_specific;
 	inbound.key = mIsClient ? mServerSessionKey : mClientSessionKey;
 	inbound.window_size = 1024;
 	inbound.allow_repeat_tx = true;
 	inbound.next = nullptr;
 
-	if (srtp_err_status_t err = srtp_add_stream(mSrtpIn, &inbound))
-		throw std::runtime_error("SRTP add inbound stream failed, status=" +
-		                         to_string(static_cast<int>(err)));
-
-	srtp_policy_t outbound = {};
-	srtp_crypto_policy_set_aes_cm_128_hmac_sha1_80(&outbound.rtp);
-	srtp_crypto_policy_set_aes_cm_128_hmac_sha1_80(&outbound.rtcp);
-	outbound.ssrc.type = ssrc_any_outbound;
+	srtp_policy_t &outbound = mOutboundPolicy;
+	setCryptoPolicy(&outbound.rtp);
+	setCryptoPolicy(&outbound.rtcp);
+	outbound.ssrc.type = ssrc_specific;
 	outbound.key = mIsClient ? mClientSessionKey : mServerSessionKey;
 	outbound.window_size = 1024;
 	outbound.allow_repeat_tx = true;
 	outbound.next = nullptr;
 
-	if (srtp_err_status_t err = srtp_add_stream(mSrtpOut, &outbound))
-		throw std::runtime_error("SRTP add outbound stream failed, status=" +
-		                         to_string(static_cast<int>(err)));
-
 	mInitDone = true;
 }
 
+srtp_t DtlsSrtpTransport::getSession(std::unordered_map<uint32_t, srtp_t> &sessions,
+                                     const srtp_policy_t &policy, uint32_t ssrc) {
+	if (auto it = sessions.find(ssrc); it != sessions.end())
+		return it->second;
+
+	PLOG_DEBUG << "Creating SRTP session for SSRC " << ssrc;
+
+	srtp_policy_t ssrcPolicy = policy;
+	ssrcPolicy.ssrc.value = ssrc;
+	srtp_t session;
+	if (srtp_err_status_t err = srtp_create(&session, &ssrcPolicy))
+		throw std::runtime_error("SRTP create failed, status=" + to_string(static_cast<int>(err)));
+
+	sessions.emplace(ssrc, session);
+	return session;
+}
+
+void DtlsSrtpTransport::eraseSession(std::unordered_map<uint32_t, srtp_t> &sessions,
+                                     uint32_t ssrc) {
+	if (auto it = sessions.find(ssrc); it != sessions.end()) {
+		srtp_dealloc(it->second);
+		sessions.erase(it);
+	}
+}
+
+void DtlsSrtpTransport::eraseReleasedSessions(std::unordered_map<uint32_t, srtp_t> &sessions,
+                                              std::vector<uint32_t> &released,
+                                              std::atomic<bool> &hasReleased) {
+	if (!hasReleased)
+		return;
+
+	std::vector<uint32_t> ssrcs;
+	{
+		std::lock_guard lock(mReleasedMutex);
+		ssrcs = std::exchange(released, {});
+		hasReleased = false;
+	}
+
+	for (uint32_t ssrc : ssrcs) {
+		PLOG_DEBUG << "Releasing SRTP session for SSRC " << ssrc;
+		eraseSession(sessions, ssrc);
+	}
+}
+
 } // namespace rtc::impl
 
 #endif
@@ -30,34 +30,72 @@
 #include "srtp.h"
 #endif
 
+#include <array>
 #include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
 
 namespace rtc::impl {
 
-class DtlsSrtpTransport final : public DtlsTransport {
+class DtlsSrtpTransport final : public DtlsTransport,
+                                public std::enable_shared_from_this<DtlsSrtpTransport> {
 public:
 	static void Init();
 	static void Cleanup();
 
 	DtlsSrtpTransport(shared_ptr<IceTransport> lower, certificate_ptr certificate,
 	                  optional<size_t> mtu, verifier_callback verifierCallback,
-	                  message_callback srtpRecvCallback, state_callback stateChangeCallback);
+	                  message_callback srtpRecvCallback, state_callback stateChangeCallback,
+	                  bool srtpNullCipher = false);
 	~DtlsSrtpTransport();
 
-	bool sendMedia(message_ptr message);
+	// Media send classes, in decreasing order of priority
+	enum class Priority : int { Audio = 0, Retransmission = 1, Video = 2, Padding = 3 };
+
+	// Returns true if sent or queued, as another thread or the thread pool might send it later.
+	// Returns false if dropped, or if the lower layer did not send it when sent by the calling
+	// thread. Errors are thrown for the caller's own message only, as queued messages of other
+	// threads might be sent by the calling thread.
+	bool sendMedia(message_ptr message, Priority priority = Priority::Video);
+	void releaseSessions(const std::vector<uint32_t> &ssrcs);
 
 private:
 	void incoming(message_ptr message) override;
 	void postHandshake() override;
 
+	bool drainMedia(const Message *own); // returns the result for own if sent
+	message_ptr dequeueMedia();
+	bool protectMedia(message_ptr message);
+
+	srtp_t getSession(std::unordered_map<uint32_t, srtp_t> &sessions, const srtp_policy_t &policy,
+	                  uint32_t ssrc);
+	void eraseSession(std::unordered_map<uint32_t, srtp_t> &sessions, uint32_t ssrc);
+	void eraseReleasedSessions(std::unordered_map<uint32_t, srtp_t> &sessions,
+	                           std::vector<uint32_t> &released, std::atomic<bool> &hasReleased);
+
 	message_callback mSrtpRecvCallback;
 
-	srtp_t mSrtpIn, mSrtpOut;
+	// One session per SSRC, as libsrtp looks up streams in a linked list on each packet
+	std::unordered_map<uint32_t, srtp_t> mSrtpIn, mSrtpOut; // by SSRC
+	srtp_policy_t mInboundPolicy = {}, mOutboundPolicy = {};
+
+	// Sessions are erased by the threads using them, on the next packet
+	std::mutex mReleasedMutex;
+	std::vector<uint32_t> mReleasedIn, mReleasedOut; // SSRCs
+	std::atomic<bool> mHasReleasedIn = false, mHasReleasedOut = false;
 
 	std::atomic<bool> mInitDone = false;
 	unsigned char mClientSessionKey[SRTP_AES_ICM_128_KEY_LEN_WSALT];
 	unsigned char mServerSessionKey[SRTP_AES_ICM_128_KEY_LEN_WSALT];
-	std::mutex sendMutex;
+
+	// Bounded queues by priority, drained by one sending thread at a time
+	static const size_t PriorityCount = 4;
+	std::mutex mSendQueuesMutex;
+	std::array<std::deque<message_ptr>, PriorityCount> mSendQueues;
+	bool mSending = false;
 };
 
 } // namespace rtc::impl
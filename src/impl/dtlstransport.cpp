@@ -47,7 +47,7 @@ void DtlsTransport::Cleanup() { gnutls_global_deinit(); }
 
 DtlsTransport::DtlsTransport(shared_ptr<IceTransport> lower, certificate_ptr certificate,
                              optional<size_t> mtu, verifier_callback verifierCallback,
-                             state_callback stateChangeCallback)
+                             state_callback stateChangeCallback, bool srtpNullCipher)
     : Transport(lower, std::move(stateChangeCallback)), mMtu(mtu), mCertificate(certificate),
       mVerifierCallback(std::move(verifierCallback)),
       mIsClient(lower->role() == Description::Role::Active), mCurrentDscp(0) {
@@ -72,6 +72,11 @@ DtlsTransport::DtlsTransport(shared_ptr<IceTransport> lower, certificate_ptr cer
 		gnutls::check(gnutls_priority_set_direct(mSession, priorities, &err_pos),
 		              "Failed to set TLS priorities");
 
+		// The null cipher profile is offered first on request, as profiles are in preference order
+		if (srtpNullCipher)
+			gnutls::check(gnutls_srtp_set_profile(mSession, GNUTLS_SRTP_NULL_HMAC_SHA1_80),
+			              "Failed to set SRTP profile");
+
 		// RFC 8827: The DTLS-SRTP protection profile SRTP_AES128_CM_HMAC_SHA1_80 MUST be supported
 		// See https://tools.ietf.org/html/rfc8827#section-6.5
 		gnutls::check(gnutls_srtp_set_profile(mSession, GNUTLS_SRTP_AES128_CM_HMAC_SHA1_80),
@@ -361,7 +366,7 @@ void DtlsTransport::Cleanup() {
 
 DtlsTransport::DtlsTransport(shared_ptr<IceTransport> lower, certificate_ptr certificate,
                              optional<size_t> mtu, verifier_callback verifierCallback,
-                             state_callback stateChangeCallback)
+                             state_callback stateChangeCallback, bool srtpNullCipher)
     : Transport(lower, std::move(stateChangeCallback)), mMtu(mtu), mCertificate(certificate),
       mVerifierCallback(std::move(verifierCallback)),
       mIsClient(lower->role() == Description::Role::Active), mCurrentDscp(0) {
@@ -429,7 +434,10 @@ DtlsTransport::DtlsTransport(shared_ptr<IceTransport> lower, certificate_ptr cer
 		// RFC 8827: The DTLS-SRTP protection profile SRTP_AES128_CM_HMAC_SHA1_80 MUST be supported
 		// See https://tools.ietf.org/html/rfc8827#section-6.5 Warning:
 		// SSL_set_tlsext_use_srtp() returns 0 on success and 1 on error
-		if (SSL_set_tlsext_use_srtp(mSsl, "SRTP_AES128_CM_SHA1_80"))
+		// The null cipher profile is offered first on request, as profiles are in preference order
+		const char *profiles =
+		    srtpNullCipher ? "SRTP_NULL_SHA1_80:SRTP_AES128_CM_SHA1_80" : "SRTP_AES128_CM_SHA1_80";
+		if (SSL_set_tlsext_use_srtp(mSsl, profiles))
 			throw std::runtime_error("Failed to set SRTP profile: " +
 			                         openssl::error_string(ERR_get_error()));
 
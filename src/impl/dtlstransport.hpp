@@ -43,13 +43,15 @@ public:
 	using verifier_callback = std::function<bool(const std::string &fingerprint)>;
 
 	DtlsTransport(shared_ptr<IceTransport> lower, certificate_ptr certificate, optional<size_t> mtu,
-	              verifier_callback verifierCallback, state_callback stateChangeCallback);
+	              verifier_callback verifierCallback, state_callback stateChangeCallback,
+	              bool srtpNullCipher = false);
 	~DtlsTransport();
 
 	virtual void start() override;
 	virtual bool stop() override;
 	virtual bool send(message_ptr message) override; // false if dropped
 
+	void interrupt() { mIncomingQueue.stop(); } // let the recv thread exit, stop() joins it
 	bool isClient() const { return mIsClient; }
 
 protected:
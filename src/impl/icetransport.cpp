@@ -19,6 +19,8 @@
 #include "icetransport.hpp"
 #include "configuration.hpp"
 #include "internals.hpp"
+#include "logcounter.hpp"
+#include "threadpool.hpp"
 #include "transport.hpp"
 
 #include <iostream>
@@ -42,17 +44,102 @@ using std::chrono::system_clock;
 
 namespace rtc::impl {
 
+static LogCounter
+    COUNTER_IN_PROCESS_QUEUE_FULL(plog::warning,
+                                  "Number of in-process packets dropped due to a full queue");
+
+std::mutex IceTransport::InProcessMutex;
+std::unordered_map<string, weak_ptr<IceTransport>> IceTransport::InProcessTransports;
+
+void IceTransport::linkInProcess(string localKey, const Description &description) {
+	if (!mInProcessEnabled || mInProcessLinked)
+		return;
+
+	auto ufrag = description.iceUfrag();
+	auto pwd = description.icePwd();
+	if (!ufrag || !pwd)
+		return;
+
+	std::lock_guard lock(InProcessMutex);
+	if (mInProcessKey.empty()) {
+		mInProcessKey = std::move(localKey);
+		InProcessTransports[mInProcessKey] = weak_from_this();
+	}
+	mInProcessRemoteKey = *ufrag + ":" + *pwd;
+
+	auto it = InProcessTransports.find(mInProcessRemoteKey);
+	if (it == InProcessTransports.end())
+		return;
+
+	auto peer = it->second.lock();
+	if (!peer || peer.get() == this || peer->mInProcessRemoteKey != mInProcessKey)
+		return;
+
+	// Both sides have the remote description, so ICE can't be connected yet. At most DTLS handshake
+	// packets might still arrive over UDP, and the DTLS transport queues them anyway.
+	mInProcessPeer = peer;
+	peer->mInProcessPeer = weak_from_this();
+	mInProcessLinked = true;
+	peer->mInProcessLinked = true;
+	PLOG_INFO << "ICE transport linked with an in-process peer";
+}
+
+void IceTransport::unlinkInProcess() {
+	if (mInProcessKey.empty())
+		return;
+
+	std::lock_guard lock(InProcessMutex);
+	if (auto it = InProcessTransports.find(mInProcessKey);
+	    it != InProcessTransports.end() && it->second.expired())
+		InProcessTransports.erase(it);
+}
+
+bool IceTransport::sendInProcess(message_ptr message) {
+	auto peer = mInProcessPeer.lock();
+	if (!peer)
+		return false;
+
+	// The message is handed over without copy, the sender does not touch it after sending. Behave
+	// like UDP and drop on overflow rather than blocking the sender.
+	if (!peer->mInProcessQueue.tryPush(std::move(message))) {
+		COUNTER_IN_PROCESS_QUEUE_FULL++;
+		return true;
+	}
+
+	if (peer->mPendingInProcessCount++ == 0) // received on the pool of the peer's connection
+		peer->mPool.enqueue([weak_peer = weak_ptr<IceTransport>(peer)]() {
+			if (auto peer = weak_peer.lock())
+				peer->doRecvInProcess();
+		});
+
+	return true;
+}
+
+void IceTransport::doRecvInProcess() {
+	int count;
+	do {
+		count = mPendingInProcessCount.load();
+		while (auto next = mInProcessQueue.tryPop()) {
+			message_ptr message = std::move(*next);
+			message->arrival = std::chrono::steady_clock::now();
+			incoming(std::move(message));
+		}
+	} while ((mPendingInProcessCount -= count) > 0);
+}
+
 #if !USE_NICE
 
 #define MAX_TURN_SERVERS_COUNT 2
 
-IceTransport::IceTransport(const Configuration &config, candidate_callback candidateCallback,
-                           state_callback stateChangeCallback,
+IceTransport::IceTransport(const Configuration &config, ThreadPool &pool,
+                           candidate_callback candidateCallback, state_callback stateChangeCallback,
                            gathering_state_callback gatheringStateChangeCallback)
     : Transport(nullptr, std::move(stateChangeCallback)), mRole(Description::Role::ActPass),
       mMid("0"), mGatheringState(GatheringState::New),
       mCandidateCallback(std::move(candidateCallback)),
       mGatheringStateChangeCallback(std::move(gatheringStateChangeCallback)),
+      mInProcessEnabled(config.enableInProcessTransport), mPool(pool),
+      mInProcessQueue(IN_PROCESS_QUEUE_LIMIT),
       mAgent(nullptr, nullptr) {
 
 	PLOG_DEBUG << "Initializing ICE transport (libjuice)";
@@ -151,6 +238,7 @@ IceTransport::IceTransport(const Configuration &config, candidate_callback candi
 
 IceTransport::~IceTransport() {
 	stop();
+	unlinkInProcess();
 	mAgent.reset();
 }
 
@@ -181,6 +269,12 @@ void IceTransport::setRemoteDescription(const Description &description) {
 	if (juice_set_remote_description(mAgent.get(),
 	                                 description.generateApplicationSdp("\r\n").c_str()) < 0)
 		throw std::runtime_error("Failed to parse ICE settings from remote SDP");
+
+	if (mInProcessEnabled) {
+		auto local = getLocalDescription(Description::Type::Answer);
+		linkInProcess(local.iceUfrag().value_or("") + ":" + local.icePwd().value_or(""),
+		              description);
+	}
 }
 
 bool IceTransport::addRemoteCandidate(const Candidate &candidate) {
@@ -247,6 +341,9 @@ bool IceTransport::send(message_ptr message) {
 }
 
 bool IceTransport::outgoing(message_ptr message) {
+	if (mInProcessLinked && sendInProcess(message))
+		return true;
+
 	// Explicit Congestion Notification takes the least-significant 2 bits of the DS field
 	int ds = int(message->dscp << 2);
 	return juice_send_diffserv(mAgent.get(), reinterpret_cast<const char *>(message->data()),
@@ -312,11 +409,15 @@ void IceTransport::GatheringDoneCallback(juice_agent_t *, void *user_ptr) {
 }
 
 void IceTransport::RecvCallback(juice_agent_t *, const char *data, size_t size, void *user_ptr) {
+	// The agent thread calls back right after reading the socket, before any queueing
+	const auto arrival = std::chrono::steady_clock::now();
 	auto iceTransport = static_cast<rtc::impl::IceTransport *>(user_ptr);
 	try {
 		PLOG_VERBOSE << "Incoming size=" << size;
 		auto b = reinterpret_cast<const byte *>(data);
-		iceTransport->incoming(make_message(b, b + size));
+		auto message = make_message(b, b + size);
+		message->arrival = arrival;
+		iceTransport->incoming(std::move(message));
 	} catch (const std::exception &e) {
 		PLOG_WARNING << e.what();
 	}
@@ -346,13 +447,15 @@ void IceTransport::LogCallback(juice_log_level_t level, const char *message) {
 
 #else // USE_NICE == 1
 
-IceTransport::IceTransport(const Configuration &config, candidate_callback candidateCallback,
-                           state_callback stateChangeCallback,
+IceTransport::IceTransport(const Configuration &config, ThreadPool &pool,
+                           candidate_callback candidateCallback, state_callback stateChangeCallback,
                            gathering_state_callback gatheringStateChangeCallback)
     : Transport(nullptr, std::move(stateChangeCallback)), mRole(Description::Role::ActPass),
       mMid("0"), mGatheringState(GatheringState::New),
       mCandidateCallback(std::move(candidateCallback)),
       mGatheringStateChangeCallback(std::move(gatheringStateChangeCallback)),
+      mInProcessEnabled(config.enableInProcessTransport), mPool(pool),
+      mInProcessQueue(IN_PROCESS_QUEUE_LIMIT),
       mNiceAgent(nullptr, nullptr), mMainLoop(nullptr, nullptr), mOutgoingDscp(0) {
 
 	PLOG_DEBUG << "Initializing ICE transport (libnice)";
@@ -530,7 +633,10 @@ IceTransport::IceTransport(const Configuration &config, candidate_callback candi
 	                       RecvCallback, this);
 }
 
-IceTransport::~IceTransport() { stop(); }
+IceTransport::~IceTransport() {
+	stop();
+	unlinkInProcess();
+}
 
 bool IceTransport::stop() {
 	if (mTimeoutId) {
@@ -582,6 +688,15 @@ void IceTransport::setRemoteDescription(const Description &description) {
 	if (nice_agent_parse_remote_sdp(mNiceAgent.get(),
 	                                description.generateApplicationSdp("\n").c_str()) < 0)
 		throw std::runtime_error("Failed to parse ICE settings from remote SDP");
+
+	// Do not call getLocalDescription() here as it changes the controlling mode
+	gchar *ufrag = nullptr, *pwd = nullptr;
+	if (mInProcessEnabled &&
+	    nice_agent_get_local_credentials(mNiceAgent.get(), mStreamId, &ufrag, &pwd)) {
+		linkInProcess(string(ufrag) + ":" + string(pwd), description);
+		g_free(ufrag);
+		g_free(pwd);
+	}
 }
 
 bool IceTransport::addRemoteCandidate(const Candidate &candidate) {
@@ -645,6 +760,9 @@ bool IceTransport::send(message_ptr message) {
 }
 
 bool IceTransport::outgoing(message_ptr message) {
+	if (mInProcessLinked && sendInProcess(message))
+		return true;
+
 	std::lock_guard lock(mOutgoingMutex);
 	if (mOutgoingDscp != message->dscp) {
 		mOutgoingDscp = message->dscp;
@@ -748,11 +866,14 @@ void IceTransport::StateChangeCallback(NiceAgent * /*agent*/, guint /*streamId*/
 
 void IceTransport::RecvCallback(NiceAgent * /*agent*/, guint /*streamId*/, guint /*componentId*/,
                                 guint len, gchar *buf, gpointer userData) {
+	const auto arrival = std::chrono::steady_clock::now();
 	auto iceTransport = static_cast<rtc::impl::IceTransport *>(userData);
 	try {
 		PLOG_VERBOSE << "Incoming size=" << len;
 		auto b = reinterpret_cast<byte *>(buf);
-		iceTransport->incoming(make_message(b, b + len));
+		auto message = make_message(b, b + len);
+		message->arrival = arrival;
+		iceTransport->incoming(std::move(message));
 	} catch (const std::exception &e) {
 		PLOG_WARNING << e.what();
 	}
@@ -24,6 +24,8 @@
 #include "configuration.hpp"
 #include "description.hpp"
 #include "peerconnection.hpp"
+#include "queue.hpp"
+#include "threadpool.hpp"
 #include "transport.hpp"
 
 #if !USE_NICE
@@ -36,18 +38,19 @@
 #include <chrono>
 #include <mutex>
 #include <thread>
+#include <unordered_map>
 
 namespace rtc::impl {
 
-class IceTransport : public Transport {
+class IceTransport : public Transport, public std::enable_shared_from_this<IceTransport> {
 public:
 	enum class GatheringState { New = 0, InProgress = 1, Complete = 2 };
 
 	using candidate_callback = std::function<void(const Candidate &candidate)>;
 	using gathering_state_callback = std::function<void(GatheringState state)>;
 
-	IceTransport(const Configuration &config, candidate_callback candidateCallback,
-	             state_callback stateChangeCallback,
+	IceTransport(const Configuration &config, ThreadPool &pool,
+	             candidate_callback candidateCallback, state_callback stateChangeCallback,
 	             gathering_state_callback gatheringStateChangeCallback);
 	~IceTransport();
 
@@ -76,6 +79,12 @@ private:
 	void processGatheringDone();
 	void processTimeout();
 
+	// In-process peers are matched by ICE credentials, see Configuration::enableInProcessTransport
+	void linkInProcess(string localKey, const Description &description);
+	void unlinkInProcess();
+	bool sendInProcess(message_ptr message);
+	void doRecvInProcess();
+
 	Description::Role mRole;
 	string mMid;
 	std::chrono::milliseconds mTrickleTimeout;
@@ -84,6 +93,17 @@ private:
 	candidate_callback mCandidateCallback;
 	gathering_state_callback mGatheringStateChangeCallback;
 
+	const bool mInProcessEnabled;
+	ThreadPool &mPool; // pool of the connection, receives in-process messages
+	string mInProcessKey, mInProcessRemoteKey;   // written under InProcessMutex
+	weak_ptr<IceTransport> mInProcessPeer;       // written once before mInProcessLinked is set
+	std::atomic<bool> mInProcessLinked = false;
+	Queue<message_ptr> mInProcessQueue;
+	std::atomic<int> mPendingInProcessCount = 0;
+
+	static std::mutex InProcessMutex;
+	static std::unordered_map<string, weak_ptr<IceTransport>> InProcessTransports;
+
 #if !USE_NICE
 	unique_ptr<juice_agent_t, void (*)(juice_agent_t *)> mAgent;
 
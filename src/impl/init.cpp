@@ -50,6 +50,7 @@ void doInit() {
 #endif
 
 	impl::ThreadPool::Instance().spawn(THREADPOOL_SIZE);
+	impl::ThreadPool::TearDownInstance().spawn(TEARDOWN_THREADPOOL_SIZE);
 
 #if USE_GNUTLS
 	// Nothing to do
@@ -68,6 +69,9 @@ void doInit() {
 }
 
 void doCleanup() {
+	// Stopping transports may wait for tasks on the other pools, so join it first
+	impl::ThreadPool::TearDownInstance().join();
+	impl::ThreadPool::JoinLoops();
 	impl::ThreadPool::Instance().join();
 
 	impl::SctpTransport::Cleanup();
@@ -37,6 +37,18 @@
 #pragma warning(pop)
 #endif
 
+// Verbose logging on hot paths can be compiled out entirely
+#if RTC_DISABLE_VERBOSE_LOGGING
+#undef PLOG_VERBOSE
+#define PLOG_VERBOSE                                                                               \
+	if (true) {                                                                                    \
+		;                                                                                          \
+	} else                                                                                         \
+		PLOG(plog::verbose)
+#undef LOG_VERBOSE
+#define LOG_VERBOSE PLOG_VERBOSE
+#endif
+
 namespace rtc {
 
 const size_t MAX_NUMERICNODE_LEN = 48; // Max IPv6 string representation length
@@ -48,8 +60,19 @@ const size_t DEFAULT_LOCAL_MAX_MESSAGE_SIZE = 256 * 1024; // Default local max m
 const size_t DEFAULT_MAX_MESSAGE_SIZE = 65536; // Remote max message size if not specified in SDP
 
 const size_t RECV_QUEUE_LIMIT = 1024 * 1024; // Max per-channel queue size
+const size_t MEDIA_SEND_QUEUE_LIMIT = 1024; // Max packets per media send priority class
+const size_t MEDIA_SEND_BATCH_SIZE = 64;    // Max packets sent by a thread before handing over
+const size_t IN_PROCESS_QUEUE_LIMIT = 1024; // Max packets queued for an in-process ICE peer
+const size_t BUSY_POLLING_QUEUE_LIMIT = 4096; // Max per-channel messages in busy-polling mode
+const size_t SRTP_MAX_INBOUND_SESSIONS = 1024; // Max inbound SRTP sessions, one per SSRC
+
+const int RTP_BRIDGE_BATCH_SIZE = 32;              // Max packets read by an RTP bridge per call
+const size_t RTP_BRIDGE_BUFFER_SIZE = 2048;        // RTP bridge receive buffer size
+const unsigned int RTP_BRIDGE_URING_BUFFERS = 256; // Buffers provided to io_uring by RTP bridges
+const unsigned int RTP_BRIDGE_XDP_FRAMES = 4096;   // UMEM frames of RTP bridge AF_XDP sockets
 
 const int THREADPOOL_SIZE = 4; // Number of threads in the global thread pool (>= 2)
+const int TEARDOWN_THREADPOOL_SIZE = 2; // Number of threads stopping transports (>= 1)
 
 const size_t DEFAULT_MTU = RTC_DEFAULT_MTU; // defined in rtc.h
 
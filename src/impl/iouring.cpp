@@ -0,0 +1,269 @@
+/**
+ * Copyright (c) 2021 Paul-Louis Ageneau
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "iouring.hpp"
+#include "logcounter.hpp"
+
+#ifndef NO_IO_URING
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cstring>
+
+namespace rtc::impl {
+
+static LogCounter COUNTER_URING_TRUNCATED(plog::warning,
+                                          "Number of truncated datagrams dropped by io_uring");
+
+namespace {
+
+const uint16_t BufferGroup = 0;
+const uint64_t RecvUserData = 1;
+const uint64_t CancelUserData = 2;
+
+template <typename T> T *offset_ptr(void *base, size_t offset) {
+	return reinterpret_cast<T *>(static_cast<char *>(base) + offset);
+}
+
+} // namespace
+
+IoUringReceiver::IoUringReceiver(socket_t sock, unsigned int buffersCount, size_t bufferSize)
+    : mSock(sock), mBufferSize(bufferSize) {
+
+	// Buffer rings need a power of two entries
+	unsigned int entries = 1;
+	while (entries < buffersCount && entries < 32768)
+		entries <<= 1;
+
+	try {
+		// Each completion consumes a buffer, so the completion ring can't overflow with more
+		// entries than buffers, as overflowing would terminate the multishot receive
+		struct io_uring_params params = {};
+		params.flags = IORING_SETUP_CQSIZE;
+		params.cq_entries = entries * 2;
+		mRingFd = int(::syscall(__NR_io_uring_setup, 8, &params));
+		if (mRingFd < 0)
+			throw std::runtime_error("io_uring setup failed, errno=" + std::to_string(errno));
+
+		if (!(params.features & IORING_FEAT_SINGLE_MMAP))
+			throw std::runtime_error("io_uring is too old");
+
+		mRingSize = std::max(params.sq_off.array + params.sq_entries * sizeof(unsigned int),
+		                     params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe));
+		mRing = ::mmap(nullptr, mRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+		               mRingFd, IORING_OFF_SQ_RING);
+		if (mRing == MAP_FAILED) {
+			mRing = nullptr;
+			throw std::runtime_error("io_uring ring mapping failed");
+		}
+
+		mSqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+		void *sqes = ::mmap(nullptr, mSqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+		                    mRingFd, IORING_OFF_SQES);
+		if (sqes == MAP_FAILED)
+			throw std::runtime_error("io_uring entries mapping failed");
+
+		mSqes = static_cast<struct io_uring_sqe *>(sqes);
+		mSqTail = offset_ptr<unsigned int>(mRing, params.sq_off.tail);
+		mSqArray = offset_ptr<unsigned int>(mRing, params.sq_off.array);
+		mSqMask = *offset_ptr<unsigned int>(mRing, params.sq_off.ring_mask);
+		mCqHead = offset_ptr<unsigned int>(mRing, params.cq_off.head);
+		mCqTail = offset_ptr<unsigned int>(mRing, params.cq_off.tail);
+		mCqMask = *offset_ptr<unsigned int>(mRing, params.cq_off.ring_mask);
+		mCqes = offset_ptr<struct io_uring_cqe>(mRing, params.cq_off.cqes);
+
+		// The buffer ring is shared with the kernel and must be page-aligned
+		mBufRingSize = entries * sizeof(struct io_uring_buf);
+		void *bufRing = ::mmap(nullptr, mBufRingSize, PROT_READ | PROT_WRITE,
+		                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (bufRing == MAP_FAILED)
+			throw std::runtime_error("io_uring buffer ring allocation failed");
+
+		// Entries are not accessed through io_uring_buf_ring as its flexible array member is
+		// misplaced when compiled as C++
+		mBufRing = static_cast<struct io_uring_buf *>(bufRing);
+		mBufMask = uint16_t(entries - 1);
+
+		struct io_uring_buf_reg reg = {};
+		reg.ring_addr = reinterpret_cast<uintptr_t>(mBufRing);
+		reg.ring_entries = entries;
+		reg.bgid = BufferGroup;
+		if (::syscall(__NR_io_uring_register, mRingFd, IORING_REGISTER_PBUF_RING, &reg, 1) < 0)
+			throw std::runtime_error("io_uring buffer ring registration failed, errno=" +
+			                         std::to_string(errno));
+
+		mBuffers.resize(entries);
+		for (unsigned int i = 0; i < entries; ++i) {
+			mBuffers[i] = make_message(mBufferSize);
+			provide(uint16_t(i), i);
+		}
+		mBufTail = uint16_t(mBufTail + entries);
+		__atomic_store_n(&mBufRing[0].resv, mBufTail, __ATOMIC_RELEASE);
+
+		arm();
+
+	} catch (...) {
+		close();
+		throw;
+	}
+}
+
+IoUringReceiver::~IoUringReceiver() { close(); }
+
+int IoUringReceiver::process(const std::function<void(message_ptr)> &callback) {
+	unsigned int head = *mCqHead;
+	unsigned int tail = __atomic_load_n(mCqTail, __ATOMIC_ACQUIRE);
+	unsigned int provided = 0;
+	int count = 0;
+	int error = 0;
+	for (; head != tail; ++head) {
+		const struct io_uring_cqe &cqe = mCqes[head & mCqMask];
+		if (cqe.user_data != RecvUserData)
+			continue;
+
+		if (!(cqe.flags & IORING_CQE_F_MORE))
+			mArmed = false; // multishot receive terminated
+
+		if (cqe.res < 0) {
+			if (cqe.res != -ENOBUFS) // buffers are provided again below
+				error = -cqe.res;
+			continue;
+		}
+
+		if (!(cqe.flags & IORING_CQE_F_BUFFER))
+			continue;
+
+		auto bid = uint16_t(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+		if (size_t(cqe.res) < mBufferSize) {
+			auto message = std::move(mBuffers[bid]);
+			message->resize(size_t(cqe.res));
+			mBuffers[bid] = make_message(mBufferSize);
+			callback(std::move(message));
+			++count;
+		} else {
+			COUNTER_URING_TRUNCATED++;
+		}
+
+		provide(bid, provided++);
+	}
+
+	__atomic_store_n(mCqHead, head, __ATOMIC_RELEASE);
+	if (provided > 0) {
+		mBufTail = uint16_t(mBufTail + provided);
+		__atomic_store_n(&mBufRing[0].resv, mBufTail, __ATOMIC_RELEASE);
+	}
+
+	if (error)
+		throw std::runtime_error("io_uring receive failed, error=" + std::to_string(error));
+
+	if (!mArmed)
+		arm();
+
+	return count;
+}
+
+void IoUringReceiver::close() {
+	if (mArmed) {
+		try {
+			cancel();
+		} catch (const std::exception &e) {
+			PLOG_WARNING << e.what();
+		}
+	}
+
+	if (mRingFd >= 0)
+		::close(mRingFd);
+	if (mBufRing)
+		::munmap(mBufRing, mBufRingSize);
+	if (mSqes)
+		::munmap(mSqes, mSqesSize);
+	if (mRing)
+		::munmap(mRing, mRingSize);
+
+	mRingFd = -1;
+	mBufRing = nullptr;
+	mSqes = nullptr;
+	mRing = nullptr;
+}
+
+void IoUringReceiver::arm() {
+	unsigned int tail = *mSqTail;
+	unsigned int index = tail & mSqMask;
+	struct io_uring_sqe &sqe = mSqes[index];
+	std::memset(&sqe, 0, sizeof(sqe));
+	sqe.opcode = IORING_OP_RECV;
+	sqe.fd = mSock;
+	sqe.ioprio = IORING_RECV_MULTISHOT;
+	sqe.flags = IOSQE_BUFFER_SELECT;
+	sqe.buf_group = BufferGroup;
+	sqe.user_data = RecvUserData;
+	mSqArray[index] = index;
+	__atomic_store_n(mSqTail, tail + 1, __ATOMIC_RELEASE);
+
+	submit(1);
+	mArmed = true;
+}
+
+void IoUringReceiver::cancel() {
+	unsigned int tail = *mSqTail;
+	unsigned int index = tail & mSqMask;
+	struct io_uring_sqe &sqe = mSqes[index];
+	std::memset(&sqe, 0, sizeof(sqe));
+	sqe.opcode = IORING_OP_ASYNC_CANCEL;
+	sqe.fd = -1;
+	sqe.addr = RecvUserData;
+	sqe.user_data = CancelUserData;
+	mSqArray[index] = index;
+	__atomic_store_n(mSqTail, tail + 1, __ATOMIC_RELEASE);
+
+	// Wait for the receive to terminate so the kernel does not write into freed buffers
+	submit(1, 1);
+	for (int attempts = 0; mArmed && attempts < 10; ++attempts) {
+		unsigned int head = *mCqHead;
+		unsigned int ctail = __atomic_load_n(mCqTail, __ATOMIC_ACQUIRE);
+		for (; head != ctail; ++head) {
+			const struct io_uring_cqe &cqe = mCqes[head & mCqMask];
+			if (cqe.user_data == RecvUserData && !(cqe.flags & IORING_CQE_F_MORE))
+				mArmed = false;
+		}
+		__atomic_store_n(mCqHead, head, __ATOMIC_RELEASE);
+		if (mArmed)
+			submit(0, 1);
+	}
+}
+
+void IoUringReceiver::submit(unsigned int count, unsigned int waitCount) {
+	unsigned int flags = waitCount > 0 ? IORING_ENTER_GETEVENTS : 0;
+	while (::syscall(__NR_io_uring_enter, mRingFd, count, waitCount, flags, nullptr, 0) < 0) {
+		if (errno != EINTR)
+			throw std::runtime_error("io_uring submission failed, errno=" + std::to_string(errno));
+	}
+}
+
+void IoUringReceiver::provide(uint16_t bid, unsigned int offset) {
+	struct io_uring_buf &buf = mBufRing[(mBufTail + offset) & mBufMask];
+	buf.addr = reinterpret_cast<uintptr_t>(mBuffers[bid]->data());
+	buf.len = uint32_t(mBufferSize);
+	buf.bid = bid;
+}
+
+} // namespace rtc::impl
+
+#endif
@@ -0,0 +1,85 @@
+/**
+ * Copyright (c) 2021 Paul-Louis Ageneau
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef RTC_IMPL_IO_URING_H
+#define RTC_IMPL_IO_URING_H
+
+#include "common.hpp"
+#include "message.hpp"
+#include "socket.hpp"
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#endif
+
+#ifndef IORING_RECV_MULTISHOT // multishot receive requires Linux 6.0 headers
+#define NO_IO_URING
+#endif
+
+#ifndef NO_IO_URING
+
+#include <functional>
+#include <vector>
+
+namespace rtc::impl {
+
+// Datagram receiver using io_uring multishot receive with a ring of provided buffers. The kernel
+// writes datagrams directly into messages, and waiting only requires polling fd().
+class IoUringReceiver final {
+public:
+	// Throws if io_uring or the required features are unavailable
+	IoUringReceiver(socket_t sock, unsigned int buffersCount, size_t bufferSize);
+	~IoUringReceiver();
+
+	int fd() const { return mRingFd; } // readable when completions are pending
+
+	// Processes pending completions, returns the number of received datagrams
+	int process(const std::function<void(message_ptr)> &callback);
+
+private:
+	void close();
+	void arm();
+	void cancel();
+	void submit(unsigned int count, unsigned int waitCount = 0);
+	void provide(uint16_t bid, unsigned int offset);
+
+	const socket_t mSock;
+	const size_t mBufferSize;
+
+	int mRingFd = -1;
+	void *mRing = nullptr;
+	size_t mRingSize = 0;
+	struct io_uring_sqe *mSqes = nullptr;
+	size_t mSqesSize = 0;
+	unsigned int *mSqTail = nullptr, *mSqArray = nullptr, mSqMask = 0;
+	unsigned int *mCqHead = nullptr, *mCqTail = nullptr, mCqMask = 0;
+	struct io_uring_cqe *mCqes = nullptr;
+
+	struct io_uring_buf *mBufRing = nullptr; // the tail overlays mBufRing[0].resv
+	size_t mBufRingSize = 0;
+	uint16_t mBufTail = 0, mBufMask = 0;
+	std::vector<message_ptr> mBuffers; // indexed by buffer id
+
+	bool mArmed = false;
+};
+
+} // namespace rtc::impl
+
+#endif
+
+#endif
@@ -0,0 +1,101 @@
+/**
+ * Copyright (c) 2020 Paul-Louis Ageneau
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "numa.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace rtc::impl {
+
+std::vector<int> parse_cpu_list(const std::string &list) {
+	std::vector<int> cpus;
+	std::istringstream ss(list);
+	std::string range;
+	while (std::getline(ss, range, ',')) {
+		if (range.empty())
+			continue;
+
+		try {
+			auto pos = range.find('-');
+			int first = std::stoi(range.substr(0, pos));
+			int last = pos != std::string::npos ? std::stoi(range.substr(pos + 1)) : first;
+			for (int cpu = first; cpu <= last; ++cpu)
+				cpus.push_back(cpu);
+		} catch (const std::logic_error &) {
+			return {}; // invalid list
+		}
+	}
+	return cpus;
+}
+
+std::vector<NumaNode> read_numa_nodes(const std::string &path, const std::vector<int> &allowed) {
+	auto read = [](const std::string &filename) -> std::string {
+		std::ifstream ifs(filename);
+		std::string line;
+		std::getline(ifs, line);
+		return line;
+	};
+
+	std::vector<NumaNode> nodes;
+	for (int id : parse_cpu_list(read(path + "/online"))) {
+		NumaNode node{id, {}};
+		for (int cpu : parse_cpu_list(read(path + "/node" + std::to_string(id) + "/cpulist")))
+			if (std::find(allowed.begin(), allowed.end(), cpu) != allowed.end())
+				node.cpus.push_back(cpu);
+
+		if (!node.cpus.empty()) // memory-only nodes or disallowed CPUs
+			nodes.push_back(std::move(node));
+	}
+	return nodes;
+}
+
+NumaLayout::NumaLayout(std::vector<NumaNode> nodes) : mNodes(std::move(nodes)) {
+	size_t maxCpus = 0;
+	for (size_t i = 0; i < mNodes.size(); ++i) {
+		mLoopNodes.insert(mLoopNodes.end(), mNodes[i].cpus.size(), i);
+		maxCpus = std::max(maxCpus, mNodes[i].cpus.size());
+	}
+
+	// Take one loop of each node in turn, so consecutive connections are spread over the nodes
+	// and each loop gets the same share
+	for (size_t rank = 0; rank < maxCpus; ++rank) {
+		size_t first = 0;
+		for (const auto &node : mNodes) {
+			if (rank < node.cpus.size())
+				mOrder.push_back(first + rank);
+
+			first += node.cpus.size();
+		}
+	}
+}
+
+size_t NumaLayout::size() const { return mLoopNodes.size(); }
+
+const NumaNode &NumaLayout::node(size_t loop) const { return mNodes.at(mLoopNodes.at(loop)); }
+
+size_t NumaLayout::next() {
+	if (mOrder.empty())
+		throw std::logic_error("No loop in NUMA layout");
+
+	return mOrder[mNext++ % mOrder.size()];
+}
+
+} // namespace rtc::impl
@@ -0,0 +1,61 @@
+/**
+ * Copyright (c) 2020 Paul-Louis Ageneau
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef RTC_IMPL_NUMA_H
+#define RTC_IMPL_NUMA_H
+
+// Standard headers only, so tests can use it with an injected topology
+#include <string>
+#include <vector>
+
+namespace rtc::impl {
+
+struct NumaNode {
+	int id;
+	std::vector<int> cpus;
+};
+
+// Parses a Linux cpulist like "0-3,8,10-11", also used for lists of nodes
+std::vector<int> parse_cpu_list(const std::string &list);
+
+// Reads the nodes from a sysfs directory like /sys/devices/system/node and keeps the allowed CPUs
+// only. Nodes without any allowed CPU are omitted, no nodes are returned without topology.
+std::vector<NumaNode> read_numa_nodes(const std::string &path, const std::vector<int> &allowed);
+
+// Layout of the loop threads, one per CPU, grouped by node
+// Only loop threads are placed for now. Still to do: node-local buffer pools for message
+// allocation, metrics for cross-node traffic, and placing the ICE and DTLS threads, which keep
+// the default affinity.
+class NumaLayout final {
+public:
+	NumaLayout(std::vector<NumaNode> nodes);
+
+	size_t size() const;                     // number of loops
+	const NumaNode &node(size_t loop) const; // node of a loop, its CPUs are the loop affinity
+	size_t next();                           // loop for the next connection, alternating nodes
+
+private:
+	std::vector<NumaNode> mNodes;
+	std::vector<size_t> mLoopNodes; // node index of each loop
+	std::vector<size_t> mOrder;     // loop indexes interleaved by node
+	size_t mNext = 0;
+};
+
+} // namespace rtc::impl
+
+#endif
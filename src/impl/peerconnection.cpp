@@ -34,7 +34,9 @@
 #include "dtlssrtptransport.hpp"
 #endif
 
+#include <algorithm>
 #include <iomanip>
+#include <iterator>
 #include <set>
 #include <thread>
 
@@ -54,7 +56,8 @@ static LogCounter
 
 PeerConnection::PeerConnection(Configuration config_)
     : config(std::move(config_)), mCertificate(make_certificate(config.certificateType)),
-      mProcessor(std::make_unique<Processor>()) {
+      mProcessor(std::make_unique<Processor>(
+          0, config.pinToLoopThread ? ThreadPool::LoopInstance() : ThreadPool::Instance())) {
 	PLOG_VERBOSE << "Creating PeerConnection";
 
 	if (config.portRangeEnd && config.portRangeBegin > config.portRangeEnd)
@@ -123,7 +126,7 @@ shared_ptr<IceTransport> PeerConnection::initIceTransport() {
 		PLOG_VERBOSE << "Starting ICE transport";
 
 		auto transport = std::make_shared<IceTransport>(
-		    config, weak_bind(&PeerConnection::processLocalCandidate, this, _1),
+		    config, mProcessor->pool(), weak_bind(&PeerConnection::processLocalCandidate, this, _1),
 		    [this, weak_this = weak_from_this()](IceTransport::State transportState) {
 			    auto shared_this = weak_this.lock();
 			    if (!shared_this)
@@ -227,7 +230,8 @@ shared_ptr<DtlsTransport> PeerConnection::initDtlsTransport() {
 			// DTLS-SRTP
 			transport = std::make_shared<DtlsSrtpTransport>(
 			    lower, certificate, config.mtu, verifierCallback,
-			    weak_bind(&PeerConnection::forwardMedia, this, _1), dtlsStateChangeCallback);
+			    weak_bind(&PeerConnection::forwardMedia, this, _1), dtlsStateChangeCallback,
+			    config.enableSrtpNullCipher);
 #else
 			PLOG_WARNING << "Ignoring media support (not compiled with media support)";
 #endif
@@ -275,7 +279,8 @@ shared_ptr<SctpTransport> PeerConnection::initSctpTransport() {
 		shiftDataChannels();
 
 		auto transport = std::make_shared<SctpTransport>(
-		    lower, config, sctpPort, weak_bind(&PeerConnection::forwardMessage, this, _1),
+		    lower, config, mProcessor->pool(), sctpPort,
+		    weak_bind(&PeerConnection::forwardMessage, this, _1),
 		    weak_bind(&PeerConnection::forwardBufferedAmount, this, _1, _2),
 		    [this, weak_this = weak_from_this()](SctpTransport::State transportState) {
 			    auto shared_this = weak_this.lock();
@@ -340,25 +345,63 @@ void PeerConnection::closeTransports() {
 
 	// Initiate transport stop on the processor after closing the data channels
 	mProcessor->enqueue([this]() {
-		// Pass the pointers to a thread
-		auto sctp = std::atomic_exchange(&mSctpTransport, decltype(mSctpTransport)(nullptr));
-		auto dtls = std::atomic_exchange(&mDtlsTransport, decltype(mDtlsTransport)(nullptr));
-		auto ice = std::atomic_exchange(&mIceTransport, decltype(mIceTransport)(nullptr));
-		ThreadPool::Instance().enqueue([sctp, dtls, ice]() mutable {
-			if (sctp)
-				sctp->stop();
-			if (dtls)
-				dtls->stop();
-			if (ice)
-				ice->stop();
-
-			sctp.reset();
-			dtls.reset();
-			ice.reset();
-		});
+		// Pass the pointers to a teardown thread, as stopping joins threads and would otherwise
+		// block workers of the global thread pool
+		TearDown tearDown;
+		tearDown.sctp = std::atomic_exchange(&mSctpTransport, decltype(mSctpTransport)(nullptr));
+		tearDown.dtls = std::atomic_exchange(&mDtlsTransport, decltype(mDtlsTransport)(nullptr));
+		tearDown.ice = std::atomic_exchange(&mIceTransport, decltype(mIceTransport)(nullptr));
+		ScheduleTearDown(std::move(tearDown));
 	});
 }
 
+std::mutex PeerConnection::TearDownMutex;
+std::vector<PeerConnection::TearDown> PeerConnection::TearDownBatch;
+bool PeerConnection::TearDownScheduled = false;
+
+void PeerConnection::ScheduleTearDown(TearDown tearDown) {
+	std::lock_guard lock(TearDownMutex);
+	TearDownBatch.emplace_back(std::move(tearDown));
+	if (!TearDownScheduled) {
+		// Closes happening until the task runs join the same batch
+		TearDownScheduled = true;
+		ThreadPool::TearDownInstance().enqueue(&PeerConnection::RunTearDown);
+	}
+}
+
+void PeerConnection::RunTearDown() {
+	std::vector<TearDown> batch;
+	{
+		std::lock_guard lock(TearDownMutex);
+		batch = std::exchange(TearDownBatch, {});
+		TearDownScheduled = false;
+	}
+
+	PLOG_DEBUG << "Stopping transports of " << batch.size() << " connections";
+
+	// Each layer is stopped for the whole batch before the next one, as SCTP must shut down
+	// before DTLS and DTLS before ICE. The DTLS recv threads are all interrupted before the first
+	// one is joined, so they exit in parallel instead of one after the other.
+	for (auto &t : batch)
+		if (t.sctp)
+			t.sctp->stop();
+
+	for (auto &t : batch)
+		if (t.dtls)
+			t.dtls->interrupt();
+
+	for (auto &t : batch)
+		if (t.dtls)
+			t.dtls->stop();
+
+	for (auto &t : batch)
+		if (t.ice)
+			t.ice->stop();
+
+	// Transports might be destroyed here, which reclaims the remaining threads
+	batch.clear();
+}
+
 void PeerConnection::endLocalCandidates() {
 	std::lock_guard lock(mLocalDescriptionMutex);
 	if (mLocalDescription)
@@ -393,6 +436,18 @@ bool PeerConnection::checkFingerprint(const std::string &fingerprint) const {
 	return false;
 }
 
+ThreadPool &PeerConnection::pool() const { return mProcessor->pool(); }
+
+bool PeerConnection::poll() {
+	// Media is received inline by the ICE transport, only SCTP is left for polling
+	auto sctpTransport = getSctpTransport();
+	if (!sctpTransport)
+		return false;
+
+	// The next message may be for any channel, so stop receiving as soon as one is full
+	return sctpTransport->poll([this]() { return fullPollQueuesCount->load() == 0; });
+}
+
 void PeerConnection::forwardMessage(message_ptr message) {
 	if (!message) {
 		remoteCloseDataChannels();
@@ -599,6 +654,59 @@ shared_ptr<DataChannel> PeerConnection::emplaceDataChannel(string label, DataCha
 	return channel;
 }
 
+std::vector<shared_ptr<DataChannel>>
+PeerConnection::emplaceDataChannels(std::vector<string> labels, DataChannelInit init) {
+	std::unique_lock lock(mDataChannelsMutex); // we are going to emplace
+
+	// Allocate all stream ids first in a single pass, so nothing is emplaced on failure
+	std::vector<uint16_t> streams;
+	streams.reserve(labels.size());
+	if (init.id) {
+		// Consecutive ids, as agreed with the remote peer
+		unsigned int stream = *init.id;
+		for (size_t i = 0; i < labels.size(); ++i, ++stream) {
+			if (stream >= 65535)
+				throw std::invalid_argument("Invalid DataChannel id");
+
+			if (mDataChannels.find(uint16_t(stream)) != mDataChannels.end())
+				throw std::invalid_argument("DataChannel id " + std::to_string(stream) +
+				                            " is already used");
+
+			streams.push_back(uint16_t(stream));
+		}
+	} else {
+		// See emplaceDataChannel() for the stream id parity
+		auto iceTransport = getIceTransport();
+		auto role = iceTransport ? iceTransport->role() : Description::Role::Passive;
+		unsigned int stream = (role == Description::Role::Active) ? 0 : 1;
+		while (streams.size() < labels.size()) {
+			if (stream >= 65535 - 2)
+				throw std::runtime_error("Too many DataChannels");
+
+			if (mDataChannels.find(uint16_t(stream)) == mDataChannels.end())
+				streams.push_back(uint16_t(stream));
+
+			stream += 2;
+		}
+	}
+
+	std::vector<shared_ptr<DataChannel>> channels;
+	channels.reserve(labels.size());
+	mDataChannels.reserve(mDataChannels.size() + labels.size());
+	for (size_t i = 0; i < labels.size(); ++i) {
+		auto channel = init.negotiated
+		                   ? std::make_shared<DataChannel>(weak_from_this(), streams[i],
+		                                                   std::move(labels[i]), init.protocol,
+		                                                   init.reliability)
+		                   : std::make_shared<NegotiatedDataChannel>(
+		                         weak_from_this(), streams[i], std::move(labels[i]),
+		                         init.protocol, init.reliability);
+		mDataChannels.emplace(std::make_pair(streams[i], channel));
+		channels.push_back(std::move(channel));
+	}
+	return channels;
+}
+
 shared_ptr<DataChannel> PeerConnection::findDataChannel(uint16_t stream) {
 	std::shared_lock lock(mDataChannelsMutex); // read-only
 	if (auto it = mDataChannels.find(stream); it != mDataChannels.end())
@@ -916,18 +1024,47 @@ void PeerConnection::processLocalCandidate(Candidate candidate) {
 }
 
 void PeerConnection::processRemoteDescription(Description description) {
+	auto mediaSsrcs = [](Description &desc) {
+		std::set<uint32_t> ssrcs;
+		for (unsigned int i = 0; i < desc.mediaCount(); ++i)
+			std::visit(rtc::overloaded{[&](Description::Application *) {},
+			                           [&](Description::Media *media) {
+				                           for (uint32_t ssrc : media->getSSRCs())
+					                           ssrcs.insert(ssrc);
+			                           }},
+			           desc.media(i));
+
+		return ssrcs;
+	};
+
+	std::vector<uint32_t> removedSsrcs;
 	{
 		// Set as remote description
 		std::lock_guard lock(mRemoteDescriptionMutex);
 
 		std::vector<Candidate> existingCandidates;
-		if (mRemoteDescription)
+		std::set<uint32_t> previousSsrcs;
+		if (mRemoteDescription) {
 			existingCandidates = mRemoteDescription->extractCandidates();
+			previousSsrcs = mediaSsrcs(*mRemoteDescription);
+		}
 
 		mRemoteDescription.emplace(description);
 		mRemoteDescription->addCandidates(std::move(existingCandidates));
+
+		auto ssrcs = mediaSsrcs(*mRemoteDescription);
+		std::set_difference(previousSsrcs.begin(), previousSsrcs.end(), ssrcs.begin(), ssrcs.end(),
+		                    std::back_inserter(removedSsrcs));
 	}
 
+#if RTC_ENABLE_MEDIA
+	// Release the SRTP sessions of SSRCs removed by renegotiation
+	if (!removedSsrcs.empty())
+		if (auto transport =
+		        std::dynamic_pointer_cast<DtlsSrtpTransport>(std::atomic_load(&mDtlsTransport)))
+			transport->releaseSessions(removedSsrcs);
+#endif
+
 	auto iceTransport = initIceTransport();
 	iceTransport->setRemoteDescription(std::move(description));
 
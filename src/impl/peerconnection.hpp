@@ -66,6 +66,8 @@ struct PeerConnection : std::enable_shared_from_this<PeerConnection> {
 	optional<string> getMidFromSsrc(uint32_t ssrc);
 
 	shared_ptr<DataChannel> emplaceDataChannel(string label, DataChannelInit init);
+	std::vector<shared_ptr<DataChannel>> emplaceDataChannels(std::vector<string> labels,
+	                                                         DataChannelInit init);
 	shared_ptr<DataChannel> findDataChannel(uint16_t stream);
 	void shiftDataChannels();
 	void iterateDataChannels(std::function<void(shared_ptr<DataChannel> channel)> func);
@@ -101,12 +103,19 @@ struct PeerConnection : std::enable_shared_from_this<PeerConnection> {
 
 	void outgoingMedia(message_ptr message);
 
+	ThreadPool &pool() const;
+	bool poll();
+
 	const Configuration config;
 	std::atomic<State> state = State::New;
 	std::atomic<GatheringState> gatheringState = GatheringState::New;
 	std::atomic<SignalingState> signalingState = SignalingState::Stable;
 	std::atomic<bool> negotiationNeeded = false;
 
+	// Busy-polling mode, count of DataChannels which can't queue an incoming message. Shared as
+	// channels might outlive the connection.
+	const shared_ptr<std::atomic<int>> fullPollQueuesCount = std::make_shared<std::atomic<int>>(0);
+
 	synchronized_callback<shared_ptr<rtc::DataChannel>> dataChannelCallback;
 	synchronized_callback<Description> localDescriptionCallback;
 	synchronized_callback<Candidate> localCandidateCallback;
@@ -116,6 +125,19 @@ struct PeerConnection : std::enable_shared_from_this<PeerConnection> {
 	synchronized_callback<shared_ptr<rtc::Track>> trackCallback;
 
 private:
+	// Transports of closed connections are stopped in batches on the teardown thread pool
+	struct TearDown {
+		shared_ptr<SctpTransport> sctp;
+		shared_ptr<DtlsTransport> dtls;
+		shared_ptr<IceTransport> ice;
+	};
+
+	static void ScheduleTearDown(TearDown tearDown);
+	static void RunTearDown();
+	static std::mutex TearDownMutex;
+	static std::vector<TearDown> TearDownBatch;
+	static bool TearDownScheduled;
+
 	const init_token mInitToken = Init::Token();
 	const future_certificate_ptr mCertificate;
 	const unique_ptr<Processor> mProcessor;
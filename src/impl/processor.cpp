@@ -18,21 +18,98 @@
 
 #include "processor.hpp"
 
+#include <chrono>
+
 namespace rtc::impl {
 
-Processor::Processor(size_t limit) : mTasks(limit) {}
+namespace {
+
+// Task of a processor running on the current thread, a task might be destroying its processor
+struct Frame {
+	const Processor *processor;
+	Frame *previous;
+	bool destroyed = false;
+};
+
+thread_local Frame *CurrentFrame = nullptr;
+
+} // namespace
+
+Processor::Processor(size_t limit, ThreadPool &pool) : mPool(pool), mTasks(limit) {}
 
-Processor::~Processor() { join(); }
+Processor::~Processor() {
+	join();
+
+	// Prevent the running tasks from chaining on the destroyed processor
+	for (auto *frame = CurrentFrame; frame; frame = frame->previous)
+		if (frame->processor == this)
+			frame->destroyed = true;
+}
 
 void Processor::join() {
+	// A task can't wait for itself to finish, so the following tasks are run inline instead
+	for (auto *frame = CurrentFrame; frame; frame = frame->previous)
+		if (frame->processor == this) {
+			drain();
+			return;
+		}
+
 	std::unique_lock lock(mMutex);
-	mCondition.wait(lock, [this]() { return !mPending && mTasks.empty(); });
+	auto idle = [this]() { return !mPending && mTasks.empty(); };
+	if (mPool.isLoop() && mPool.isWorker()) {
+		// Waiting would block the single thread of the loop, which the tasks need, for instance
+		// when the connection is released from one of its callbacks, so help instead. Workers of
+		// the global pool keep blocking as other workers are available to run the tasks.
+		using namespace std::chrono_literals;
+		while (!idle()) {
+			lock.unlock();
+			bool ran = mPool.tryRunOne();
+			lock.lock();
+			if (!ran)
+				mCondition.wait_for(lock, 1ms, idle); // the task might be delayed or elsewhere
+		}
+		return;
+	}
+
+	mCondition.wait(lock, idle);
+}
+
+void Processor::run(const std::function<void()> &func) {
+	Frame frame{this, CurrentFrame};
+	CurrentFrame = &frame;
+	scope_guard guard([this, &frame]() {
+		CurrentFrame = frame.previous;
+		if (!frame.destroyed)
+			schedule(); // chain the next task
+	});
+	func();
+}
+
+void Processor::drain() {
+	Frame frame{this, CurrentFrame};
+	CurrentFrame = &frame;
+	scope_guard guard([&frame]() { CurrentFrame = frame.previous; });
+
+	std::unique_lock lock(mMutex);
+	bool wasDraining = std::exchange(mDraining, true);
+	while (auto next = mTasks.tryPop()) {
+		lock.unlock();
+		(*next)();
+		if (frame.destroyed)
+			return;
+
+		lock.lock();
+	}
+	mDraining = wasDraining;
 }
 
 void Processor::schedule() {
 	std::unique_lock lock(mMutex);
+	if (mDraining)
+		return; // join() runs the next task
+
 	if (auto next = mTasks.tryPop()) {
-		ThreadPool::Instance().enqueue(std::move(*next));
+		mPool.enqueue(std::move(*next));
 	} else {
 		// No more tasks
 		mPending = false;
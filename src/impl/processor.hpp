@@ -35,7 +35,7 @@ namespace rtc::impl {
 // Processed tasks in order by delegating them to the thread pool
 class Processor final {
 public:
-	Processor(size_t limit = 0);
+	Processor(size_t limit = 0, ThreadPool &pool = ThreadPool::Instance());
 	~Processor();
 
 	Processor(const Processor &) = delete;
@@ -44,17 +44,23 @@ public:
 	Processor &operator=(Processor &&) = delete;
 
 	void join();
+	ThreadPool &pool() const { return mPool; }
 
 	template <class F, class... Args> void enqueue(F &&f, Args &&...args);
 
 protected:
+	void run(const std::function<void()> &func);
 	void schedule();
+	void drain();
 
 	// Keep an init token
 	const init_token mInitToken = Init::Token();
 
+	ThreadPool &mPool;
+
 	Queue<std::function<void()>> mTasks;
-	bool mPending = false; // true iff a task is pending in the thread pool
+	bool mPending = false;  // true iff a task is pending in the thread pool
+	bool mDraining = false; // true while join() runs the queued tasks inline
 
 	mutable std::mutex mMutex;
 	std::condition_variable mCondition;
@@ -63,13 +69,10 @@ protected:
 template <class F, class... Args> void Processor::enqueue(F &&f, Args &&...args) {
 	std::unique_lock lock(mMutex);
 	auto bound = std::bind(std::forward<F>(f), std::forward<Args>(args)...);
-	auto task = [this, bound = std::move(bound)]() mutable {
-		scope_guard guard(std::bind(&Processor::schedule, this)); // chain the next task
-		return bound();
-	};
+	auto task = [this, bound = std::move(bound)]() mutable { run([&bound]() { bound(); }); };
 
 	if (!mPending) {
-		ThreadPool::Instance().enqueue(std::move(task));
+		mPool.enqueue(std::move(task));
 		mPending = true;
 	} else {
 		mTasks.push(std::move(task));
@@ -43,6 +43,7 @@ public:
 	size_t size() const;   // elements
 	size_t amount() const; // amount
 	void push(T element);
+	bool tryPush(T element); // never waits, returns false if the queue is full
 	optional<T> pop();
 	optional<T> tryPop();
 	optional<T> peek();
@@ -111,6 +112,15 @@ template <typename T> void Queue<T>::push(T element) {
 	pushImpl(std::move(element));
 }
 
+template <typename T> bool Queue<T>::tryPush(T element) {
+	std::unique_lock lock(mMutex);
+	if (mLimit && mQueue.size() >= mLimit)
+		return false;
+
+	pushImpl(std::move(element));
+	return true;
+}
+
 template <typename T> optional<T> Queue<T>::pop() {
 	std::unique_lock lock(mMutex);
 	mPopCondition.wait(lock, [this]() { return !mQueue.empty() || mStopping; });
@@ -0,0 +1,167 @@
+/**
+ * Copyright (c) 2019 Paul-Louis Ageneau
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef RTC_IMPL_RING_H
+#define RTC_IMPL_RING_H
+
+#include "common.hpp"
+
+#include <atomic>
+#include <functional>
+#include <memory>
+
+namespace rtc::impl {
+
+// Bounded lock-free queue, which never blocks nor waits. Any thread may push or pop, however
+// peek() requires a single consumer.
+template <typename T> class Ring {
+public:
+	using amount_function = std::function<size_t(const T &element)>;
+
+	Ring(size_t limit, amount_function func = nullptr);
+	~Ring() = default;
+
+	bool empty() const;
+	size_t size() const;   // elements
+	size_t amount() const; // amount
+	bool full() const;     // exact for a single producer
+	bool push(T element);  // false if full
+	optional<T> pop();
+	optional<T> peek();
+
+private:
+	static size_t Capacity(size_t limit);
+
+	struct Cell {
+		std::atomic<size_t> sequence;
+		T element;
+	};
+
+	const size_t mMask;
+	const std::unique_ptr<Cell[]> mCells;
+	amount_function mAmountFunction;
+	std::atomic<size_t> mAmount = 0;
+
+	// Positions are on distinct cache lines as producers and consumer run on distinct threads
+	alignas(64) std::atomic<size_t> mPushPosition = 0;
+	alignas(64) std::atomic<size_t> mPopPosition = 0;
+};
+
+template <typename T> size_t Ring<T>::Capacity(size_t limit) {
+	// Positions are masked, so the capacity must be a power of two
+	size_t capacity = 2;
+	while (capacity < limit)
+		capacity <<= 1;
+
+	return capacity;
+}
+
+template <typename T>
+Ring<T>::Ring(size_t limit, amount_function func)
+    : mMask(Capacity(limit) - 1), mCells(new Cell[mMask + 1]) {
+	mAmountFunction = func ? func : [](const T &element) -> size_t {
+		static_cast<void>(element);
+		return 1;
+	};
+
+	// A cell is ready for the push at the position equal to its sequence
+	for (size_t i = 0; i <= mMask; ++i)
+		mCells[i].sequence.store(i, std::memory_order_relaxed);
+}
+
+template <typename T> bool Ring<T>::empty() const { return size() == 0; }
+
+template <typename T> size_t Ring<T>::size() const {
+	size_t pop = mPopPosition.load(std::memory_order_relaxed);
+	size_t push = mPushPosition.load(std::memory_order_relaxed);
+	return push > pop ? push - pop : 0;
+}
+
+template <typename T> size_t Ring<T>::amount() const {
+	return mAmount.load(std::memory_order_relaxed);
+}
+
+template <typename T> bool Ring<T>::full() const {
+	// Same check as push(), as a cell is not available before the pop releases it
+	size_t position = mPushPosition.load(std::memory_order_relaxed);
+	size_t sequence = mCells[position & mMask].sequence.load(std::memory_order_acquire);
+	return static_cast<std::ptrdiff_t>(sequence - position) < 0;
+}
+
+template <typename T> bool Ring<T>::push(T element) {
+	size_t position = mPushPosition.load(std::memory_order_relaxed);
+	Cell *cell;
+	while (true) {
+		cell = &mCells[position & mMask];
+		size_t sequence = cell->sequence.load(std::memory_order_acquire);
+		auto diff = static_cast<std::ptrdiff_t>(sequence - position);
+		if (diff == 0) {
+			if (mPushPosition.compare_exchange_weak(position, position + 1,
+			                                        std::memory_order_relaxed))
+				break;
+		} else if (diff < 0) {
+			return false; // full
+		} else {
+			position = mPushPosition.load(std::memory_order_relaxed);
+		}
+	}
+
+	// Account before publishing so the amount never goes below zero
+	mAmount += mAmountFunction(element);
+	cell->element = std::move(element);
+	cell->sequence.store(position + 1, std::memory_order_release);
+	return true;
+}
+
+template <typename T> optional<T> Ring<T>::pop() {
+	size_t position = mPopPosition.load(std::memory_order_relaxed);
+	Cell *cell;
+	while (true) {
+		cell = &mCells[position & mMask];
+		size_t sequence = cell->sequence.load(std::memory_order_acquire);
+		auto diff = static_cast<std::ptrdiff_t>(sequence - (position + 1));
+		if (diff == 0) {
+			if (mPopPosition.compare_exchange_weak(position, position + 1,
+			                                       std::memory_order_relaxed))
+				break;
+		} else if (diff < 0) {
+			return nullopt; // empty
+		} else {
+			position = mPopPosition.load(std::memory_order_relaxed);
+		}
+	}
+
+	optional<T> element{std::move(cell->element)};
+	cell->element = T();
+	cell->sequence.store(position + mMask + 1, std::memory_order_release);
+	mAmount -= mAmountFunction(*element);
+	return element;
+}
+
+template <typename T> optional<T> Ring<T>::peek() {
+	size_t position = mPopPosition.load(std::memory_order_relaxed);
+	const Cell &cell = mCells[position & mMask];
+	if (cell.sequence.load(std::memory_order_acquire) != position + 1)
+		return nullopt;
+
+	return std::make_optional(cell.element);
+}
+
+} // namespace rtc::impl
+
+#endif
@@ -0,0 +1,404 @@
+/**
+ * Copyright (c) 2021 Paul-Louis Ageneau
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#if RTC_ENABLE_MEDIA
+
+#include "rtpbridge.hpp"
+#include "internals.hpp"
+#include "logcounter.hpp"
+
+#include "rtc/rtp.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace rtc::impl {
+
+static LogCounter COUNTER_BRIDGE_TRUNCATED(plog::warning,
+                                           "Number of truncated packets dropped by RTP bridges");
+static LogCounter COUNTER_BRIDGE_BAD_PACKET(plog::warning,
+                                            "Number of invalid packets dropped by RTP bridges");
+static LogCounter COUNTER_BRIDGE_EGRESS_FAIL(plog::warning,
+                                             "Number of packets RTP bridges failed to forward");
+
+RtpBridge::RtpBridge(Configuration config, message_callback ingestCallback)
+    : mConfig(std::move(config)), mIngestCallback(std::move(ingestCallback)) {
+	PLOG_VERBOSE << "Creating RTP bridge";
+
+	bind();
+	try {
+		if (mConfig.egressAddress)
+			resolveEgress();
+
+		if (mConfig.enableIoUring) {
+#ifndef NO_IO_URING
+			try {
+				mUring = std::make_unique<IoUringReceiver>(mSock, RTP_BRIDGE_URING_BUFFERS,
+				                                           RTP_BRIDGE_BUFFER_SIZE);
+				PLOG_DEBUG << "RTP bridge is using io_uring";
+			} catch (const std::exception &e) {
+				PLOG_WARNING << "io_uring is unavailable, falling back to recvmmsg: " << e.what();
+			}
+#else
+			PLOG_WARNING << "io_uring is not supported on this platform";
+#endif
+		}
+
+		if (mConfig.xdpInterface) {
+#ifndef NO_XDP
+			try {
+				// Only datagrams to the bound address and port are redirected
+				mXdp = std::make_unique<XdpReceiver>(
+				    *mConfig.xdpInterface, mConfig.xdpQueue,
+				    reinterpret_cast<const struct sockaddr *>(&mBindAddr), RTP_BRIDGE_XDP_FRAMES);
+				PLOG_DEBUG << "RTP bridge is using AF_XDP on " << *mConfig.xdpInterface;
+			} catch (const std::exception &e) {
+				PLOG_WARNING << "AF_XDP is unavailable, falling back to the socket: " << e.what();
+			}
+#else
+			PLOG_WARNING << "AF_XDP is not supported on this platform";
+#endif
+		}
+
+		updateBackend();
+		mThread = std::thread(&RtpBridge::runLoop, this);
+
+	} catch (...) {
+		::closesocket(mSock);
+		throw;
+	}
+}
+
+RtpBridge::~RtpBridge() {
+	PLOG_VERBOSE << "Destroying RTP bridge";
+	stop();
+#ifndef NO_IO_URING
+	mUring.reset(); // cancels the pending receive
+#endif
+#ifndef NO_XDP
+	mXdp.reset(); // detaches the XDP program
+#endif
+	::closesocket(mSock);
+}
+
+void RtpBridge::stop() {
+	if (mStopped.exchange(true))
+		return;
+
+	PLOG_DEBUG << "Stopping RTP bridge thread";
+	mInterrupter.interrupt();
+	mThread.join();
+}
+
+bool RtpBridge::egress(message_ptr message) {
+	if (mEgressAddrLen == 0 || mStopped)
+		return false;
+
+	if (::sendto(mSock, reinterpret_cast<const char *>(message->data()), int(message->size()), 0,
+	             reinterpret_cast<const struct sockaddr *>(&mEgressAddr), mEgressAddrLen) < 0) {
+		// The packet is dropped like it would be by a full socket buffer
+		COUNTER_BRIDGE_EGRESS_FAIL++;
+		PLOG_VERBOSE << "RTP bridge send failed, errno=" << sockerrno;
+	}
+	return true;
+}
+
+void RtpBridge::bind() {
+	PLOG_DEBUG << "Binding RTP bridge on " << mConfig.bindAddress << ":" << mConfig.port;
+
+	struct addrinfo hints = {};
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_DGRAM;
+	hints.ai_protocol = IPPROTO_UDP;
+	hints.ai_flags = AI_NUMERICHOST | AI_NUMERICSERV | AI_PASSIVE;
+
+	struct addrinfo *result = nullptr;
+	if (::getaddrinfo(mConfig.bindAddress.c_str(), std::to_string(mConfig.port).c_str(), &hints,
+	                  &result))
+		throw std::invalid_argument("Invalid RTP bridge bind address: " + mConfig.bindAddress);
+
+	try {
+		mSock = ::socket(result->ai_family, SOCK_DGRAM, IPPROTO_UDP);
+		if (mSock == INVALID_SOCKET)
+			throw std::runtime_error("RTP bridge socket creation failed");
+
+		// Set non-blocking
+		ctl_t b = 1;
+		if (::ioctlsocket(mSock, FIONBIO, &b) < 0)
+			throw std::runtime_error("Failed to set socket non-blocking mode");
+
+		// A larger buffer absorbs bursts like video key frames
+		const sockopt_t bufferSize = 4 * 1024 * 1024;
+		if (::setsockopt(mSock, SOL_SOCKET, SO_RCVBUF, (const char *)&bufferSize,
+		                 sizeof(bufferSize)) < 0)
+			PLOG_WARNING << "Failed to set RTP bridge receive buffer size, errno=" << sockerrno;
+
+		if (::bind(mSock, result->ai_addr, socklen_t(result->ai_addrlen)) < 0) {
+			PLOG_WARNING << "RTP bridge socket binding on port " << mConfig.port
+			             << " failed, errno=" << sockerrno;
+			throw std::runtime_error("RTP bridge socket binding failed");
+		}
+
+		socklen_t addrlen = sizeof(mBindAddr);
+		if (::getsockname(mSock, reinterpret_cast<struct sockaddr *>(&mBindAddr), &addrlen) < 0)
+			throw std::runtime_error("getsockname failed");
+
+		switch (mBindAddr.ss_family) {
+		case AF_INET:
+			mPort = ntohs(reinterpret_cast<struct sockaddr_in *>(&mBindAddr)->sin_port);
+			break;
+		case AF_INET6:
+			mPort = ntohs(reinterpret_cast<struct sockaddr_in6 *>(&mBindAddr)->sin6_port);
+			break;
+		default:
+			throw std::logic_error("Unknown address family");
+		}
+	} catch (...) {
+		freeaddrinfo(result);
+		if (mSock != INVALID_SOCKET) {
+			::closesocket(mSock);
+			mSock = INVALID_SOCKET;
+		}
+		throw;
+	}
+
+	freeaddrinfo(result);
+}
+
+void RtpBridge::resolveEgress() {
+	struct sockaddr_storage local;
+	socklen_t locallen = sizeof(local);
+	if (::getsockname(mSock, reinterpret_cast<struct sockaddr *>(&local), &locallen) < 0)
+		throw std::runtime_error("getsockname failed");
+
+	// The egress address must have the family of the bound socket
+	struct addrinfo hints = {};
+	hints.ai_family = local.ss_family;
+	hints.ai_socktype = SOCK_DGRAM;
+	hints.ai_protocol = IPPROTO_UDP;
+	hints.ai_flags = AI_NUMERICSERV;
+
+	struct addrinfo *result = nullptr;
+	if (::getaddrinfo(mConfig.egressAddress->c_str(), std::to_string(mConfig.egressPort).c_str(),
+	                  &hints, &result))
+		throw std::invalid_argument("Resolution failed for RTP bridge egress address: " +
+		                            *mConfig.egressAddress);
+
+	std::memcpy(&mEgressAddr, result->ai_addr, result->ai_addrlen);
+	mEgressAddrLen = socklen_t(result->ai_addrlen);
+	freeaddrinfo(result);
+}
+
+void RtpBridge::runLoop() {
+	PLOG_INFO << "Starting RTP bridge on port " << mPort;
+
+	std::vector<message_ptr> buffers(RTP_BRIDGE_BATCH_SIZE);
+	try {
+		while (!mStopped) {
+			// With io_uring, the ring becomes readable when datagrams have been received
+			socket_t fd = mSock;
+#ifndef NO_IO_URING
+			if (mUring)
+				fd = mUring->fd();
+#endif
+			fd_set readfds;
+			FD_ZERO(&readfds);
+			FD_SET(fd, &readfds);
+			int n = std::max(mInterrupter.prepare(readfds), SOCKET_TO_INT(fd) + 1);
+#ifndef NO_XDP
+			// Traffic not redirected by the XDP program still reaches the socket
+			if (mXdp) {
+				FD_SET(mXdp->fd(), &readfds);
+				n = std::max(n, mXdp->fd() + 1);
+			}
+#endif
+			int ret = ::select(n, &readfds, NULL, NULL, NULL);
+			if (ret < 0) {
+				if (sockerrno == SEINTR || sockerrno == SEAGAIN) // interrupted
+					continue;
+				else
+					throw std::runtime_error("Failed to wait on RTP bridge socket");
+			}
+
+#ifndef NO_XDP
+			if (mXdp && FD_ISSET(mXdp->fd(), &readfds))
+				recvXdp();
+#endif
+			if (!FD_ISSET(fd, &readfds))
+				continue;
+
+#ifndef NO_IO_URING
+			if (mUring) {
+				recvUring();
+				continue;
+			}
+#endif
+			while (!mStopped && recvBatch(buffers) == RTP_BRIDGE_BATCH_SIZE)
+				; // the socket might have more packets
+		}
+	} catch (const std::exception &e) {
+		PLOG_ERROR << "RTP bridge: " << e.what();
+	}
+
+	PLOG_INFO << "Stopped RTP bridge";
+}
+
+#ifndef NO_IO_URING
+void RtpBridge::recvUring() {
+	try {
+		int count = mUring->process([this](message_ptr message) { ingest(std::move(message)); });
+		mReceivedCounts[int(Backend::IoUring)] += size_t(count);
+	} catch (const std::exception &e) {
+		// Typically multishot receive is unsupported by the kernel, datagrams not received yet
+		// are left on the socket
+		PLOG_WARNING << "io_uring failed, falling back to recvmmsg: " << e.what();
+		mUring.reset();
+		updateBackend();
+	}
+}
+#endif
+
+#ifndef NO_XDP
+void RtpBridge::recvXdp() {
+	try {
+		int count = mXdp->process([this](message_ptr message) { ingest(std::move(message)); });
+		mReceivedCounts[int(Backend::Xdp)] += size_t(count);
+	} catch (const std::exception &e) {
+		PLOG_WARNING << "AF_XDP failed, falling back to the socket: " << e.what();
+		mXdp.reset();
+		updateBackend();
+	}
+}
+#endif
+
+int RtpBridge::recvBatch(std::vector<message_ptr> &buffers) {
+	// Buffers are only replaced once handed over to the track, so the capacity left after
+	// resizing usually lets SRTP protect in place
+	for (auto &buffer : buffers)
+		if (!buffer)
+			buffer = make_message(RTP_BRIDGE_BUFFER_SIZE);
+
+#ifdef __linux__
+	struct mmsghdr msgs[RTP_BRIDGE_BATCH_SIZE] = {};
+	struct iovec iovs[RTP_BRIDGE_BATCH_SIZE];
+	for (int i = 0; i < RTP_BRIDGE_BATCH_SIZE; ++i) {
+		iovs[i].iov_base = buffers[i]->data();
+		iovs[i].iov_len = buffers[i]->size();
+		msgs[i].msg_hdr.msg_iov = &iovs[i];
+		msgs[i].msg_hdr.msg_iovlen = 1;
+	}
+
+	int count = ::recvmmsg(mSock, msgs, RTP_BRIDGE_BATCH_SIZE, MSG_DONTWAIT, nullptr);
+	if (count < 0) {
+		if (sockerrno == SEAGAIN || sockerrno == SEWOULDBLOCK)
+			return 0;
+
+		throw std::runtime_error("RTP bridge recv failed, errno=" + std::to_string(sockerrno));
+	}
+
+	for (int i = 0; i < count; ++i) {
+		if (msgs[i].msg_hdr.msg_flags & MSG_TRUNC) {
+			COUNTER_BRIDGE_TRUNCATED++;
+			continue; // keep the buffer
+		}
+
+		auto message = std::move(buffers[i]);
+		message->resize(msgs[i].msg_len);
+		ingest(std::move(message));
+	}
+#else
+	int count = 0;
+	while (count < RTP_BRIDGE_BATCH_SIZE) {
+		auto &buffer = buffers[count];
+		int len = ::recv(mSock, reinterpret_cast<char *>(buffer->data()), int(buffer->size()), 0);
+		if (len < 0) {
+			if (sockerrno == SEAGAIN || sockerrno == SEWOULDBLOCK)
+				break;
+
+			throw std::runtime_error("RTP bridge recv failed, errno=" + std::to_string(sockerrno));
+		}
+
+		++count;
+		if (size_t(len) >= buffer->size()) {
+			COUNTER_BRIDGE_TRUNCATED++;
+			continue;
+		}
+
+		auto message = std::move(buffer);
+		message->resize(size_t(len));
+		ingest(std::move(message));
+	}
+#endif
+
+	mReceivedCounts[int(Backend::Socket)] += size_t(count);
+	return count;
+}
+
+size_t RtpBridge::receivedCount(Backend backend) const {
+	return mReceivedCounts[int(backend)].load();
+}
+
+void RtpBridge::updateBackend() {
+#ifndef NO_XDP
+	if (mXdp) {
+		mBackend = Backend::Xdp;
+		return;
+	}
+#endif
+#ifndef NO_IO_URING
+	if (mUring) {
+		mBackend = Backend::IoUring;
+		return;
+	}
+#endif
+	mBackend = Backend::Socket;
+}
+
+void RtpBridge::ingest(message_ptr message) {
+	if (message->size() < sizeof(RTP) || reinterpret_cast<RTP *>(message->data())->version() != 2) {
+		COUNTER_BRIDGE_BAD_PACKET++;
+		return;
+	}
+
+	// Range 64-95 (inclusive) MUST be RTCP, see RFC 5761
+	uint8_t value2 = std::to_integer<uint8_t>(*(message->begin() + 1)) & 0x7F;
+	if (value2 >= 64 && value2 <= 95) {
+		// Every RTCP packet type has the sender SSRC right after the common header
+		if (mConfig.ssrc)
+			reinterpret_cast<RTCP_RR *>(message->data())->setSenderSSRC(*mConfig.ssrc);
+
+		message->type = Message::Control;
+
+	} else {
+		auto rtp = reinterpret_cast<RTP *>(message->data());
+		if (mConfig.ssrc)
+			rtp->setSsrc(*mConfig.ssrc);
+		if (mConfig.payloadType)
+			rtp->setPayloadType(*mConfig.payloadType);
+	}
+
+	try {
+		mIngestCallback(std::move(message));
+	} catch (const std::exception &e) {
+		PLOG_DEBUG << "RTP bridge failed to send on track: " << e.what();
+	}
+}
+
+} // namespace rtc::impl
+
+#endif
@@ -0,0 +1,99 @@
+/**
+ * Copyright (c) 2021 Paul-Louis Ageneau
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef RTC_IMPL_RTP_BRIDGE_H
+#define RTC_IMPL_RTP_BRIDGE_H
+
+#if RTC_ENABLE_MEDIA
+
+#include "common.hpp"
+#include "iouring.hpp"
+#include "message.hpp"
+#include "selectinterrupter.hpp"
+#include "socket.hpp"
+#include "xdp.hpp"
+
+#include "rtc/rtpbridge.hpp"
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace rtc::impl {
+
+class RtpBridge final {
+public:
+	using Configuration = rtc::RtpBridge::Configuration;
+	using Backend = rtc::RtpBridge::Backend;
+
+	RtpBridge(Configuration config, message_callback ingestCallback);
+	~RtpBridge();
+
+	void stop();
+	bool egress(message_ptr message); // false if not forwarded
+
+	uint16_t port() const { return mPort; }
+	Backend backend() const { return mBackend; }
+	size_t receivedCount(Backend backend) const;
+
+private:
+	void bind();
+	void resolveEgress();
+	void runLoop();
+	int recvBatch(std::vector<message_ptr> &buffers);
+#ifndef NO_IO_URING
+	void recvUring();
+#endif
+#ifndef NO_XDP
+	void recvXdp();
+#endif
+	void ingest(message_ptr message);
+	void updateBackend();
+
+	const Configuration mConfig;
+	const message_callback mIngestCallback;
+
+	uint16_t mPort = 0;
+	socket_t mSock = INVALID_SOCKET;
+	struct sockaddr_storage mBindAddr = {};
+	struct sockaddr_storage mEgressAddr = {};
+	socklen_t mEgressAddrLen = 0;
+
+#ifndef NO_IO_URING
+	std::unique_ptr<IoUringReceiver> mUring; // null if disabled or unsupported
+#endif
+#ifndef NO_XDP
+	std::unique_ptr<XdpReceiver> mXdp; // null if disabled or unsupported
+#endif
+
+	// Updated by the thread, read by the application
+	std::atomic<Backend> mBackend = Backend::Socket;
+	std::array<std::atomic<size_t>, 3> mReceivedCounts = {}; // by backend
+
+	SelectInterrupter mInterrupter;
+	std::thread mThread;
+	std::atomic<bool> mStopped = false;
+};
+
+} // namespace rtc::impl
+
+#endif
+
+#endif
@@ -0,0 +1,76 @@
+/**
+ * Copyright (c) 2021 Paul-Louis Ageneau
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "sctppacket.hpp"
+
+#include <algorithm>
+
+namespace rtc::impl {
+
+namespace {
+
+uint16_t read_uint16(const std::byte *p) {
+	return uint16_t(std::to_integer<uint16_t>(p[0]) << 8 | std::to_integer<uint16_t>(p[1]));
+}
+
+uint32_t read_uint32(const std::byte *p) {
+	return uint32_t(read_uint16(p)) << 16 | read_uint16(p + 2);
+}
+
+} // namespace
+
+uint8_t sctp_first_chunk_type(const std::byte *data, size_t len) {
+	return len > SCTP_COMMON_HEADER_SIZE ? std::to_integer<uint8_t>(data[SCTP_COMMON_HEADER_SIZE])
+	                                     : 0;
+}
+
+bool sctp_has_zero_checksum_acceptable(const std::byte *data, size_t len) {
+	const size_t chunkBegin = SCTP_COMMON_HEADER_SIZE;
+	if (len < chunkBegin + 4)
+		return false;
+
+	const size_t chunkEnd = std::min(len, chunkBegin + read_uint16(data + chunkBegin + 2));
+	size_t offset = chunkBegin + 20; // chunk header and fixed parameters
+	while (offset + 4 <= chunkEnd) {
+		const uint16_t type = read_uint16(data + offset);
+		const size_t paramLen = read_uint16(data + offset + 2);
+		if (paramLen < 4 || offset + paramLen > chunkEnd)
+			break;
+
+		if (type == SCTP_PARAM_ZERO_CHECKSUM_ACCEPTABLE && paramLen >= 8 &&
+		    read_uint32(data + offset + 4) == SCTP_EDMID_DTLS)
+			return true;
+
+		offset += (paramLen + 3) & ~size_t(3); // padding
+	}
+	return false;
+}
+
+uint32_t sctp_read_checksum(const std::byte *data) {
+	const std::byte *p = data + SCTP_CHECKSUM_OFFSET;
+	return std::to_integer<uint32_t>(p[0]) | std::to_integer<uint32_t>(p[1]) << 8 |
+	       std::to_integer<uint32_t>(p[2]) << 16 | std::to_integer<uint32_t>(p[3]) << 24;
+}
+
+void sctp_write_checksum(std::byte *data, uint32_t checksum) {
+	std::byte *p = data + SCTP_CHECKSUM_OFFSET;
+	for (int i = 0; i < 4; ++i)
+		p[i] = std::byte((checksum >> (8 * i)) & 0xFF);
+}
+
+} // namespace rtc::impl
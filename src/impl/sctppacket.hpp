@@ -0,0 +1,52 @@
+/**
+ * Copyright (c) 2021 Paul-Louis Ageneau
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef RTC_IMPL_SCTP_PACKET_H
+#define RTC_IMPL_SCTP_PACKET_H
+
+// Standard headers only, so tests can use it
+#include <cstddef>
+#include <cstdint>
+
+namespace rtc::impl {
+
+// See https://tools.ietf.org/html/rfc4960#section-3
+const size_t SCTP_COMMON_HEADER_SIZE = 12;
+const size_t SCTP_CHECKSUM_OFFSET = 8;
+const uint8_t SCTP_CHUNK_INIT = 1;
+const uint8_t SCTP_CHUNK_INIT_ACK = 2;
+
+// See https://datatracker.ietf.org/doc/html/draft-ietf-tsvwg-sctp-zero-checksum
+const uint16_t SCTP_PARAM_ZERO_CHECKSUM_ACCEPTABLE = 0x8001;
+const uint32_t SCTP_EDMID_DTLS = 1;
+
+// INIT and INIT ACK chunks must not be bundled with other chunks
+uint8_t sctp_first_chunk_type(const std::byte *data, size_t len);
+
+// Returns true if the INIT or INIT ACK chunk at the beginning of the packet contains the Zero
+// Checksum Acceptable parameter with DTLS as Error Detection Method. The packet must have been
+// validated first, as the parameter changes how our own packets are sent.
+bool sctp_has_zero_checksum_acceptable(const std::byte *data, size_t len);
+
+// The checksum is stored in little-endian order, see https://tools.ietf.org/html/rfc4960#appendix-B
+uint32_t sctp_read_checksum(const std::byte *data);
+void sctp_write_checksum(std::byte *data, uint32_t checksum);
+
+} // namespace rtc::impl
+
+#endif
@@ -17,9 +17,12 @@
  */
 
 #include "sctptransport.hpp"
+#include "crc32c.hpp"
 #include "dtlstransport.hpp"
 #include "internals.hpp"
 #include "logcounter.hpp"
+#include "sctppacket.hpp"
+#include "threadpool.hpp"
 
 #include <chrono>
 #include <exception>
@@ -75,6 +78,9 @@ template <typename T> uint32_t to_uint32(T i) {
 		throw std::invalid_argument("Integer out of range");
 }
 
+// Same period as the usrsctp timer thread
+const auto SCTP_TIMERS_PERIOD = 10ms;
+
 } // namespace
 
 namespace rtc::impl {
@@ -86,6 +92,8 @@ static LogCounter
                           "Number of SCTP packets received with an bad notification length");
 static LogCounter COUNTER_BAD_SCTP_STATUS(plog::warning,
                                           "Number of SCTP packets received with a bad status");
+static LogCounter COUNTER_BAD_CHECKSUM(plog::warning,
+                                       "Number of SCTP packets received with a bad checksum");
 
 class SctpTransport::InstancesSet {
 public:
@@ -99,6 +107,11 @@ public:
 		mSet.erase(instance);
 	}
 
+	bool empty() {
+		std::shared_lock lock(mMutex);
+		return mSet.empty();
+	}
+
 	using shared_lock = std::shared_lock<std::shared_mutex>;
 	optional<shared_lock> lock(SctpTransport *instance) {
 		shared_lock lock(mMutex);
@@ -112,8 +125,18 @@ private:
 
 SctpTransport::InstancesSet *SctpTransport::Instances = new InstancesSet;
 
+std::atomic<bool> SctpTransport::ZeroChecksum = true;
+
+std::mutex SctpTransport::TimersMutex;
+bool SctpTransport::TimersScheduled = false;
+steady_clock::time_point SctpTransport::TimersLastTime;
+
 void SctpTransport::Init() {
-	usrsctp_init(0, &SctpTransport::WriteCallback, nullptr);
+	// Do not start the usrsctp timer thread, timers are handled in the thread pool instead
+	usrsctp_init_nothreads(0, &SctpTransport::WriteCallback, nullptr);
+	// CRC32c is computed and verified in handleWrite() and incoming() instead of usrsctp, so we can
+	// use hardware instructions and omit it when zero checksum is negotiated.
+	usrsctp_enable_crc32c_offload();
 	usrsctp_sysctl_set_sctp_pr_enable(1);  // Enable Partial Reliability Extension (RFC 3758)
 	usrsctp_sysctl_set_sctp_ecn_enable(0); // Disable Explicit Congestion Notification
 }
@@ -165,18 +188,26 @@ void SctpTransport::SetSettings(const SctpSettings &s) {
 	// Heartbeat interval
 	usrsctp_sysctl_set_sctp_heartbeat_interval_default(
 	    to_uint32(s.heartbeatInterval.value_or(10000ms).count()));
+
+	// Zero checksum is enabled by default as DTLS already protects integrity
+	ZeroChecksum = s.zeroChecksum.value_or(true);
 }
 
 void SctpTransport::Cleanup() {
-	while (usrsctp_finish() != 0)
-		std::this_thread::sleep_for(100ms);
+	// Closed sockets and associations are only freed by their timers, and the thread pool is joined
+	// at this point, so the timers must be handled here until usrsctp is done
+	while (usrsctp_finish() != 0) {
+		std::this_thread::sleep_for(SCTP_TIMERS_PERIOD);
+		UpdateTimers();
+	}
 }
 
 SctpTransport::SctpTransport(shared_ptr<Transport> lower, const Configuration &config,
-                             uint16_t port, message_callback recvCallback,
+                             ThreadPool &pool, uint16_t port, message_callback recvCallback,
                              amount_callback bufferedAmountCallback,
                              state_callback stateChangeCallback)
     : Transport(lower, std::move(stateChangeCallback)), mPort(port),
+      mBusyPolling(config.enableBusyPolling), mProcessor(0, pool),
       mSendQueue(0, message_size_func), mBufferedAmountCallback(std::move(bufferedAmountCallback)) {
 	onRecv(recvCallback);
 
@@ -184,6 +215,7 @@ SctpTransport::SctpTransport(shared_ptr<Transport> lower, const Configuration &c
 
 	usrsctp_register_address(this);
 	Instances->insert(this);
+	ScheduleTimers();
 
 	mSock = usrsctp_socket(AF_CONN, SOCK_STREAM, IPPROTO_SCTP, nullptr, nullptr, 0, nullptr);
 	if (!mSock)
@@ -272,6 +304,24 @@ SctpTransport::SctpTransport(shared_ptr<Transport> lower, const Configuration &c
 		throw std::runtime_error("Could not set socket option SCTP_PEER_ADDR_PARAMS, errno=" +
 		                         std::to_string(errno));
 
+	// Announce that we accept packets with zero checksum, as SCTP runs over DTLS which already
+	// provides integrity. Older usrsctp versions can't announce it, so the CRC is always checked.
+	// See https://datatracker.ietf.org/doc/html/draft-ietf-tsvwg-sctp-zero-checksum
+#ifdef SCTP_ACCEPT_ZERO_CHECKSUM
+	if (ZeroChecksum) {
+		struct sctp_assoc_value zav = {};
+		zav.assoc_id = SCTP_ALL_ASSOC;
+		zav.assoc_value = SCTP_EDMID_LOWER_LAYER_DTLS;
+		if (usrsctp_setsockopt(mSock, IPPROTO_SCTP, SCTP_ACCEPT_ZERO_CHECKSUM, &zav, sizeof(zav)))
+			throw std::runtime_error(
+			    "Could not set socket option SCTP_ACCEPT_ZERO_CHECKSUM, errno=" +
+			    std::to_string(errno));
+
+		mZeroChecksumAccepted = true;
+		PLOG_VERBOSE << "SCTP zero checksum accepted";
+	}
+#endif
+
 	// RFC 8831 6.2. SCTP Association Management
 	// The number of streams negotiated during SCTP association setup SHOULD be 65535, which is the
 	// maximum number of streams that can be negotiated during the association setup.
@@ -323,6 +373,9 @@ SctpTransport::~SctpTransport() {
 
 	usrsctp_deregister_address(this);
 	Instances->erase(this);
+
+	for (auto &page : mBufferedAmountPages)
+		delete[] page.load();
 }
 
 void SctpTransport::start() {
@@ -351,6 +404,7 @@ bool SctpTransport::stop() {
 void SctpTransport::close() {
 	if (mSock) {
 		mProcessor.join();
+		std::lock_guard lock(mRecvMutex); // poll() might be receiving
 		usrsctp_close(mSock);
 		mSock = nullptr;
 	}
@@ -450,6 +504,11 @@ void SctpTransport::incoming(message_ptr message) {
 
 	PLOG_VERBOSE << "Incoming size=" << message->size();
 
+	if (!checkChecksum(message->data(), message->size())) {
+		COUNTER_BAD_CHECKSUM++;
+		return;
+	}
+
 	usrsctp_conninput(this, message->data(), message->size(), 0);
 }
 
@@ -460,11 +519,46 @@ bool SctpTransport::outgoing(message_ptr message) {
 	return Transport::outgoing(std::move(message));
 }
 
+bool SctpTransport::poll(const ready_callback &ready) {
+	if (!mBusyPolling || mPendingRecvCount == 0)
+		return false;
+
+	// Receiving consumes the pending count, so only one thread may poll
+	if (mPolling.exchange(true))
+		return false;
+
+	bool processed = false;
+	if (mPendingRecvCount > 0 && ready()) {
+		std::lock_guard lock(mRecvMutex);
+		--mPendingRecvCount;
+		if (!recvPending(ready))
+			++mPendingRecvCount; // data is left, receive it on the next poll
+
+		processed = true;
+	}
+
+	mPolling = false;
+	return processed;
+}
+
 void SctpTransport::doRecv() {
 	std::lock_guard lock(mRecvMutex);
 	--mPendingRecvCount;
+	recvPending(nullptr);
+}
+
+bool SctpTransport::recvPending(const ready_callback &ready) {
+	// Requires mRecvMutex to be locked
+	if (!mSock)
+		return true;
+
 	try {
 		while (state() != State::Disconnected && state() != State::Failed) {
+			// Leave data in the SCTP receive window until the receiver is ready, so the window
+			// closes and the remote sender buffers instead of messages being dropped
+			if (ready && !ready())
+				return false;
+
 			const size_t bufferSize = 65536;
 			byte buffer[bufferSize];
 			socklen_t fromlen = 0;
@@ -512,6 +606,7 @@ void SctpTransport::doRecv() {
 	} catch (const std::exception &e) {
 		PLOG_WARNING << e.what();
 	}
+	return true;
 }
 
 void SctpTransport::doFlush() {
@@ -565,7 +660,9 @@ bool SctpTransport::trySendMessage(message_ptr message) {
 	// TODO: Implement SCTP ndata specification draft when supported everywhere
 	// See https://tools.ietf.org/html/draft-ietf-tsvwg-sctp-ndata-08
 
-	const Reliability reliability = message->reliability ? *message->reliability : Reliability();
+	static const Reliability DefaultReliability;
+	const Reliability &reliability =
+	    message->reliability ? *message->reliability : DefaultReliability;
 
 	struct sctp_sendv_spa spa = {};
 
@@ -621,17 +718,60 @@ bool SctpTransport::trySendMessage(message_ptr message) {
 	return true;
 }
 
+size_t SctpTransport::bufferedAmount(uint16_t streamId) const {
+	const BufferedAmount *page = mBufferedAmountPages[streamId / BufferedAmountPageSize].load();
+	return page ? page[streamId % BufferedAmountPageSize].amount.load() : 0;
+}
+
 void SctpTransport::updateBufferedAmount(uint16_t streamId, ptrdiff_t delta) {
 	// Requires mSendMutex to be locked
-	auto it = mBufferedAmount.insert(std::make_pair(streamId, 0)).first;
-	size_t amount = size_t(std::max(ptrdiff_t(it->second) + delta, ptrdiff_t(0)));
-	if (amount == 0)
-		mBufferedAmount.erase(it);
-	else
-		it->second = amount;
+	auto &pagePtr = mBufferedAmountPages[streamId / BufferedAmountPageSize];
+	BufferedAmount *page = pagePtr.load();
+	if (!page) {
+		page = new BufferedAmount[BufferedAmountPageSize];
+		pagePtr.store(page);
+	}
+
+	auto &entry = page[streamId % BufferedAmountPageSize];
+	size_t amount = size_t(std::max(ptrdiff_t(entry.amount.load()) + delta, ptrdiff_t(0)));
+	entry.amount.store(amount);
+	if (amount > entry.peak.load())
+		entry.peak.store(amount);
+
+	if (!std::exchange(entry.dirty, true))
+		mDirtyBufferedAmounts.push_back(streamId);
 
-	// Synchronously call the buffered amount callback
-	triggerBufferedAmount(streamId, amount);
+	// Callbacks are coalesced and called asynchronously, without the send lock held
+	if (!std::exchange(mPendingBufferedAmount, true))
+		mProcessor.enqueue(&SctpTransport::doBufferedAmount, this);
+}
+
+void SctpTransport::doBufferedAmount() {
+	std::vector<std::pair<uint16_t, size_t>> peaks, amounts;
+	{
+		std::lock_guard lock(mSendMutex);
+		mPendingBufferedAmount = false;
+		for (uint16_t streamId : mDirtyBufferedAmounts) {
+			auto &entry =
+			    mBufferedAmountPages[streamId / BufferedAmountPageSize]
+			        .load()[streamId % BufferedAmountPageSize];
+			entry.dirty = false;
+			size_t amount = entry.amount.load();
+			size_t peak = entry.peak.exchange(amount);
+			// Report the peak first so a rise and fall in the same cycle crosses the threshold
+			if (peak > amount)
+				peaks.emplace_back(streamId, peak);
+
+			amounts.emplace_back(streamId, amount);
+		}
+		mDirtyBufferedAmounts.clear();
+	}
+
+	for (auto [streamId, peak] : peaks)
+		triggerBufferedAmount(streamId, peak);
+
+	for (auto [streamId, amount] : amounts)
+		triggerBufferedAmount(streamId, amount);
 }
 
 void SctpTransport::triggerBufferedAmount(uint16_t streamId, size_t amount) {
@@ -679,7 +819,8 @@ void SctpTransport::handleUpcall() {
 
 	if (events & SCTP_EVENT_READ && mPendingRecvCount == 0) {
 		++mPendingRecvCount;
-		mProcessor.enqueue(&SctpTransport::doRecv, this);
+		if (!mBusyPolling) // otherwise poll() receives
+			mProcessor.enqueue(&SctpTransport::doRecv, this);
 	}
 
 	if (events & SCTP_EVENT_WRITE && mPendingFlushCount == 0) {
@@ -693,6 +834,12 @@ int SctpTransport::handleWrite(byte *data, size_t len, uint8_t /*tos*/, uint8_t
 		std::unique_lock lock(mWriteMutex);
 		PLOG_VERBOSE << "Handle write, len=" << len;
 
+		// CRC32c is offloaded to us, and packets with INIT must always carry it
+		if (len >= SCTP_COMMON_HEADER_SIZE &&
+		    (!ZeroChecksum || !mPeerZeroChecksumAccepted ||
+		     sctp_first_chunk_type(data, len) == SCTP_CHUNK_INIT))
+			sctp_write_checksum(data, Crc32c(data, len));
+
 		if (!outgoing(make_message(data, data + len)))
 			return -1;
 
@@ -707,6 +854,29 @@ int SctpTransport::handleWrite(byte *data, size_t len, uint8_t /*tos*/, uint8_t
 	return 0; // success
 }
 
+bool SctpTransport::checkChecksum(byte *data, size_t len) {
+	if (len < SCTP_COMMON_HEADER_SIZE)
+		return false;
+
+	const uint8_t chunkType = sctp_first_chunk_type(data, len);
+	const uint32_t checksum = sctp_read_checksum(data);
+	bool valid;
+	if (checksum == 0 && mZeroChecksumAccepted && chunkType != SCTP_CHUNK_INIT) {
+		valid = true;
+	} else {
+		// The checksum is computed with the field set to zero
+		sctp_write_checksum(data, 0);
+		valid = Crc32c(data, len) == checksum;
+		sctp_write_checksum(data, checksum);
+	}
+
+	// Only trust the parameters of a validated packet
+	if (valid && (chunkType == SCTP_CHUNK_INIT || chunkType == SCTP_CHUNK_INIT_ACK))
+		mPeerZeroChecksumAccepted = sctp_has_zero_checksum_acceptable(data, len);
+
+	return valid;
+}
+
 void SctpTransport::processData(binary &&data, uint16_t sid, PayloadId ppid) {
 	PLOG_VERBOSE << "Process data, size=" << data.size();
 
@@ -879,6 +1049,40 @@ optional<milliseconds> SctpTransport::rtt() {
 	return milliseconds(status.sstat_primary.spinfo_srtt);
 }
 
+void SctpTransport::ScheduleTimers() {
+	std::lock_guard lock(TimersMutex);
+	if (std::exchange(TimersScheduled, true))
+		return;
+
+	TimersLastTime = steady_clock::now();
+	ThreadPool::Instance().schedule(SCTP_TIMERS_PERIOD, &SctpTransport::HandleTimers);
+}
+
+void SctpTransport::UpdateTimers() {
+	uint32_t elapsed;
+	{
+		std::lock_guard lock(TimersMutex);
+		auto now = steady_clock::now();
+		elapsed = uint32_t(duration_cast<milliseconds>(now - TimersLastTime).count());
+		TimersLastTime += milliseconds(elapsed); // keep the remainder for next time
+	}
+
+	usrsctp_handle_timers(elapsed);
+}
+
+void SctpTransport::HandleTimers() {
+	UpdateTimers();
+
+	std::lock_guard lock(TimersMutex);
+	if (Instances->empty()) {
+		// Stop until a new instance is created
+		TimersScheduled = false;
+		return;
+	}
+
+	ThreadPool::Instance().schedule(SCTP_TIMERS_PERIOD, &SctpTransport::HandleTimers);
+}
+
 void SctpTransport::UpcallCallback(struct socket *, void *arg, int /* flags */) {
 	auto *transport = static_cast<SctpTransport *>(arg);
 
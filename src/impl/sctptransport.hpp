@@ -25,10 +25,11 @@
 #include "queue.hpp"
 #include "transport.hpp"
 
+#include <chrono>
 #include <condition_variable>
 #include <functional>
-#include <map>
 #include <mutex>
+#include <vector>
 
 #include "usrsctp.h"
 
@@ -41,17 +42,20 @@ public:
 	static void Cleanup();
 
 	using amount_callback = std::function<void(uint16_t streamId, size_t amount)>;
+	using ready_callback = std::function<bool()>;
 
-	SctpTransport(shared_ptr<Transport> lower, const Configuration &config, uint16_t port,
-	              message_callback recvCallback, amount_callback bufferedAmountCallback,
-	              state_callback stateChangeCallback);
+	SctpTransport(shared_ptr<Transport> lower, const Configuration &config, ThreadPool &pool,
+	              uint16_t port, message_callback recvCallback,
+	              amount_callback bufferedAmountCallback, state_callback stateChangeCallback);
 	~SctpTransport();
 
 	void start() override;
 	bool stop() override;
 	bool send(message_ptr message) override; // false if buffered
 	bool flush();
+	bool poll(const ready_callback &ready); // busy-polling mode, true if data was processed
 	void closeStream(unsigned int stream);
+	size_t bufferedAmount(uint16_t streamId) const; // lock-free
 
 	// Stats
 	void clearStats();
@@ -79,36 +83,54 @@ private:
 	bool outgoing(message_ptr message) override;
 
 	void doRecv();
+	bool recvPending(const ready_callback &ready); // false if stopped as not ready
 	void doFlush();
 	bool trySendQueue();
 	bool trySendMessage(message_ptr message);
 	void updateBufferedAmount(uint16_t streamId, ptrdiff_t delta);
+	void doBufferedAmount();
 	void triggerBufferedAmount(uint16_t streamId, size_t amount);
 	void sendReset(uint16_t streamId);
 
 	void handleUpcall();
 	int handleWrite(byte *data, size_t len, uint8_t tos, uint8_t set_df);
+	bool checkChecksum(byte *data, size_t len);
 
 	void processData(binary &&data, uint16_t streamId, PayloadId ppid);
 	void processNotification(const union sctp_notification *notify, size_t len);
 
 	const uint16_t mPort;
+	const bool mBusyPolling; // receive on poll() instead of the processor
 	struct socket *mSock;
 
 	Processor mProcessor;
 	std::atomic<int> mPendingRecvCount = 0;
 	std::atomic<int> mPendingFlushCount = 0;
+	std::atomic<bool> mPolling = false; // a thread is in poll()
 	std::mutex mRecvMutex;
-	std::recursive_mutex mSendMutex; // buffered amount callback is synchronous
+	std::recursive_mutex mSendMutex; // allow reentrant sends
 	Queue<message_ptr> mSendQueue;
-	std::map<uint16_t, size_t> mBufferedAmount;
 	amount_callback mBufferedAmountCallback;
 
+	// Buffered amounts are written under mSendMutex and read lock-free, in pages allocated on use
+	struct BufferedAmount {
+		std::atomic<size_t> amount = 0;
+		std::atomic<size_t> peak = 0; // since last callback
+		bool dirty = false;
+	};
+	static const size_t BufferedAmountPageSize = 256;
+	std::atomic<BufferedAmount *> mBufferedAmountPages[65536 / BufferedAmountPageSize] = {};
+	std::vector<uint16_t> mDirtyBufferedAmounts; // streams changed since last callbacks
+	bool mPendingBufferedAmount = false;         // callbacks task is pending
+
 	std::mutex mWriteMutex;
 	std::condition_variable mWrittenCondition;
 	std::atomic<bool> mWritten = false;     // written outside lock
 	std::atomic<bool> mWrittenOnce = false; // same
 
+	bool mZeroChecksumAccepted = false;                  // we accept zero checksums
+	std::atomic<bool> mPeerZeroChecksumAccepted = false; // the peer accepts zero checksums
+
 	binary mPartialMessage, mPartialNotification;
 	binary mPartialStringData, mPartialBinaryData;
 
@@ -120,6 +142,16 @@ private:
 
 	class InstancesSet;
 	static InstancesSet *Instances;
+
+	// usrsctp timers are driven by the thread pool while instances exist
+	static void ScheduleTimers();
+	static void UpdateTimers(); // handles the timers elapsed since the last update
+	static void HandleTimers();
+	static std::mutex TimersMutex;
+	static bool TimersScheduled;
+	static std::chrono::steady_clock::time_point TimersLastTime;
+
+	static std::atomic<bool> ZeroChecksum;
 };
 
 } // namespace rtc::impl
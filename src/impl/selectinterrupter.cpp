@@ -19,7 +19,7 @@
 #include "selectinterrupter.hpp"
 #include "internals.hpp"
 
-#if RTC_ENABLE_WEBSOCKET
+#if RTC_ENABLE_WEBSOCKET || RTC_ENABLE_MEDIA
 
 #ifndef _WIN32
 #include <fcntl.h>
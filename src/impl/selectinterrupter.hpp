@@ -22,7 +22,7 @@
 #include "common.hpp"
 #include "socket.hpp"
 
-#if RTC_ENABLE_WEBSOCKET
+#if RTC_ENABLE_WEBSOCKET || RTC_ENABLE_MEDIA
 
 #include <mutex>
 
@@ -17,14 +17,105 @@
  */
 
 #include "threadpool.hpp"
+#include "numa.hpp"
+
+#include <algorithm>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
 
 namespace rtc::impl {
 
+namespace {
+
+std::mutex LoopsMutex;
+std::vector<ThreadPool *> Loops;
+std::unique_ptr<NumaLayout> LoopsLayout;
+bool LoopsPinned = false;
+
+thread_local const ThreadPool *CurrentPool = nullptr; // pool of the current worker thread
+
+std::vector<int> available_cpus() {
+	std::vector<int> cpus;
+#ifdef __linux__
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	if (sched_getaffinity(0, sizeof(set), &set) == 0)
+		for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+			if (CPU_ISSET(cpu, &set))
+				cpus.push_back(cpu);
+#endif
+	return cpus;
+}
+
+NumaLayout make_loops_layout(bool &pinned) {
+	auto cpus = available_cpus();
+	pinned = !cpus.empty();
+	if (!pinned) {
+		// No affinity support, loops are not pinned
+		cpus.resize(std::max(std::thread::hardware_concurrency(), 1u));
+		for (size_t i = 0; i < cpus.size(); ++i)
+			cpus[i] = int(i);
+
+		return NumaLayout({NumaNode{0, std::move(cpus)}});
+	}
+
+	auto nodes = read_numa_nodes("/sys/devices/system/node", cpus);
+	if (nodes.empty()) {
+		PLOG_DEBUG << "NUMA topology is not available, assuming a single node";
+		nodes.push_back(NumaNode{0, std::move(cpus)});
+	}
+
+	PLOG_DEBUG << "Using loop threads on " << nodes.size() << " NUMA node(s)";
+	return NumaLayout(std::move(nodes));
+}
+
+} // namespace
+
 ThreadPool &ThreadPool::Instance() {
 	static ThreadPool *instance = new ThreadPool;
 	return *instance;
 }
 
+ThreadPool &ThreadPool::TearDownInstance() {
+	static ThreadPool *instance = new ThreadPool;
+	return *instance;
+}
+
+ThreadPool &ThreadPool::LoopInstance() {
+	std::unique_lock lock(LoopsMutex);
+	if (!LoopsLayout) {
+		// One loop per allowed CPU, pinned to the CPUs of its node so that the memory it allocates
+		// first is node-local while the scheduler may still balance loops within the node
+		LoopsLayout = std::make_unique<NumaLayout>(make_loops_layout(LoopsPinned));
+		for (size_t i = 0; i < LoopsLayout->size(); ++i) {
+			auto loop = new ThreadPool;
+			loop->mLoop = true;
+			Loops.push_back(loop);
+		}
+	}
+
+	// Connections are assigned to the loops of each node in turn. Loops are spawned lazily, so no
+	// thread is created if the feature is not used.
+	size_t index = LoopsLayout->next();
+	ThreadPool *loop = Loops[index];
+	if (loop->count() == 0) {
+		loop->spawn(1);
+		if (LoopsPinned)
+			loop->pin(LoopsLayout->node(index).cpus);
+	}
+
+	return *loop;
+}
+
+void ThreadPool::JoinLoops() {
+	std::unique_lock lock(LoopsMutex);
+	for (auto *loop : Loops)
+		loop->join();
+}
+
 ThreadPool::ThreadPool() {}
 
 ThreadPool::~ThreadPool() {}
@@ -40,6 +131,23 @@ void ThreadPool::spawn(int count) {
 		mWorkers.emplace_back(std::bind(&ThreadPool::run, this));
 }
 
+void ThreadPool::pin(const std::vector<int> &cpus) {
+#ifdef __linux__
+	std::unique_lock lock(mWorkersMutex);
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	for (int cpu : cpus)
+		if (cpu >= 0 && cpu < CPU_SETSIZE)
+			CPU_SET(cpu, &set);
+
+	for (auto &w : mWorkers)
+		if (int err = pthread_setaffinity_np(w.native_handle(), sizeof(set), &set))
+			PLOG_WARNING << "Failed to pin thread to " << cpus.size() << " CPU(s), error=" << err;
+#else
+	(void)cpus;
+#endif
+}
+
 void ThreadPool::join() {
 	{
 		std::unique_lock lock(mMutex);
@@ -59,7 +167,11 @@ void ThreadPool::join() {
 
 void ThreadPool::run() {
 	++mBusyWorkers;
-	scope_guard guard([&]() { --mBusyWorkers; });
+	CurrentPool = this;
+	scope_guard guard([&]() {
+		CurrentPool = nullptr;
+		--mBusyWorkers;
+	});
 	while (runOne()) {
 	}
 }
@@ -72,6 +184,18 @@ bool ThreadPool::runOne() {
 	return false;
 }
 
+bool ThreadPool::tryRunOne() {
+	if (auto task = tryDequeue()) {
+		task();
+		return true;
+	}
+	return false;
+}
+
+bool ThreadPool::isWorker() const { return CurrentPool == this; }
+
+bool ThreadPool::isLoop() const { return mLoop; }
+
 std::function<void()> ThreadPool::dequeue() {
 	std::unique_lock lock(mMutex);
 	while (!mJoining) {
@@ -96,4 +220,14 @@ std::function<void()> ThreadPool::dequeue() {
 	return nullptr;
 }
 
+std::function<void()> ThreadPool::tryDequeue() {
+	std::unique_lock lock(mMutex);
+	if (mJoining || mTasks.empty() || mTasks.top().time > clock::now())
+		return nullptr;
+
+	auto func = std::move(mTasks.top().func);
+	mTasks.pop();
+	return func;
+}
+
 } // namespace rtc::impl
@@ -45,6 +45,9 @@ public:
 	using clock = std::chrono::steady_clock;
 
 	static ThreadPool &Instance();
+	static ThreadPool &TearDownInstance(); // for blocking transport stops, keeps Instance() free
+	static ThreadPool &LoopInstance();     // next single-threaded loop, assigned round-robin
+	static void JoinLoops();
 
 	ThreadPool(const ThreadPool &) = delete;
 	ThreadPool &operator=(const ThreadPool &) = delete;
@@ -53,9 +56,13 @@ public:
 
 	int count() const;
 	void spawn(int count = 1);
+	void pin(const std::vector<int> &cpus); // set the affinity of current workers, only on Linux
 	void join();
 	void run();
 	bool runOne();
+	bool tryRunOne();      // run a task only if one is ready, never waits
+	bool isWorker() const; // true if called from a worker thread of this pool
+	bool isLoop() const;   // true if this pool is a single-threaded loop
 
 	template <class F, class... Args>
 	auto enqueue(F &&f, Args &&...args) -> invoke_future_t<F, Args...>;
@@ -70,11 +77,13 @@ protected:
 	ThreadPool();
 	~ThreadPool();
 
-	std::function<void()> dequeue(); // returns null function if joining
+	std::function<void()> dequeue();    // returns null function if joining
+	std::function<void()> tryDequeue(); // returns null function if no task is ready
 
 	std::vector<std::thread> mWorkers;
 	std::atomic<int> mBusyWorkers = 0;
 	std::atomic<bool> mJoining = false;
+	bool mLoop = false;
 
 	struct Task {
 		clock::time_point time;
@@ -20,6 +20,9 @@
 #include "internals.hpp"
 #include "logcounter.hpp"
 #include "peerconnection.hpp"
+#include "rtp.hpp"
+
+#include <algorithm>
 
 namespace rtc::impl {
 
@@ -30,7 +33,13 @@ static LogCounter COUNTER_QUEUE_FULL(plog::warning,
 
 Track::Track(weak_ptr<PeerConnection> pc, Description::Media description)
     : mPeerConnection(pc), mMediaDescription(std::move(description)),
-      mRecvQueue(RECV_QUEUE_LIMIT, message_size_func) {}
+      mRecvQueue(RECV_QUEUE_LIMIT, message_size_func) {
+	updatePayloadTypes();
+
+	if (auto locked = pc.lock(); locked && locked->config.enableBusyPolling)
+		mPollQueue =
+		    std::make_unique<Ring<message_ptr>>(BUSY_POLLING_QUEUE_LIMIT, message_size_func);
+}
 
 string Track::mid() const {
 	std::shared_lock lock(mMutex);
@@ -53,30 +62,59 @@ void Track::setDescription(Description::Media description) {
 		throw std::logic_error("Media description mid does not match track mid");
 
 	mMediaDescription = std::move(description);
+	updatePayloadTypes();
+}
+
+void Track::updatePayloadTypes() {
+	// Called in constructor or under lock
+	mRtxPayloadTypes.clear();
+	mFecPayloadTypes.clear();
+	for (auto it = mMediaDescription.beginMaps(); it != mMediaDescription.endMaps(); ++it) {
+		const auto &format = it->second.format;
+		if (format == "rtx")
+			mRtxPayloadTypes.push_back(it->first);
+		else if (format == "ulpfec" || format == "flexfec" || format == "flexfec-03")
+			mFecPayloadTypes.push_back(it->first);
+	}
 }
 
 void Track::close() {
 	mIsClosed = true;
 
+#if RTC_ENABLE_MEDIA
+	// The transport keeps one SRTP session per SSRC
+	shared_ptr<DtlsSrtpTransport> transport;
+	std::vector<uint32_t> ssrcs;
+	{
+		std::shared_lock lock(mMutex);
+		transport = mDtlsSrtpTransport.lock();
+		ssrcs = Description::Media(mMediaDescription).getSSRCs();
+	}
+	if (transport)
+		transport->releaseSessions(ssrcs);
+#endif
+
 	setMediaHandler(nullptr);
 	resetCallbacks();
 }
 
 optional<message_variant> Track::receive() {
-	if (auto next = mRecvQueue.tryPop())
+	if (auto next = mPollQueue ? mPollQueue->pop() : mRecvQueue.tryPop())
 		return to_variant(std::move(**next));
 
 	return nullopt;
 }
 
 optional<message_variant> Track::peek() {
-	if (auto next = mRecvQueue.peek())
+	if (auto next = mPollQueue ? mPollQueue->peek() : mRecvQueue.peek())
 		return to_variant(std::move(**next));
 
 	return nullopt;
 }
 
-size_t Track::availableAmount() const { return mRecvQueue.amount(); }
+size_t Track::availableAmount() const {
+	return mPollQueue ? mPollQueue->amount() : mRecvQueue.amount();
+}
 
 bool Track::isOpen(void) const {
 #if RTC_ENABLE_MEDIA
@@ -126,6 +164,14 @@ void Track::incoming(message_ptr message) {
 			return;
 	}
 
+	// In busy-polling mode, the application receives without any callback
+	if (mPollQueue) {
+		if (!mPollQueue->push(message))
+			COUNTER_QUEUE_FULL++;
+
+		return;
+	}
+
 	// Tail drop if queue is full
 	if (mRecvQueue.full()) {
 		COUNTER_QUEUE_FULL++;
@@ -158,6 +204,7 @@ bool Track::outgoing(message_ptr message) {
 bool Track::transportSend([[maybe_unused]] message_ptr message) {
 #if RTC_ENABLE_MEDIA
 	shared_ptr<DtlsSrtpTransport> transport;
+	DtlsSrtpTransport::Priority priority;
 	{
 		std::shared_lock lock(mMutex);
 		transport = mDtlsSrtpTransport.lock();
@@ -170,15 +217,62 @@ bool Track::transportSend([[maybe_unused]] message_ptr message) {
 			message->dscp = 46; // EF: Expedited Forwarding
 		else
 			message->dscp = 36; // AF42: Assured Forwarding class 4, medium drop probability
+
+		priority = sendPriority(*message);
 	}
 
-	return transport->sendMedia(message);
+	return transport->sendMedia(message, priority);
 #else
 	PLOG_WARNING << "Ignoring track send (not compiled with media support)";
 	return false;
 #endif
 }
 
+#if RTC_ENABLE_MEDIA
+DtlsSrtpTransport::Priority Track::sendPriority(const Message &message) const {
+	// Called under lock
+	using Priority = DtlsSrtpTransport::Priority;
+
+	// Audio and RTCP are small and latency-sensitive
+	if (message.type == Message::Control || mMediaDescription.type() == "audio")
+		return Priority::Audio;
+
+	if (message.retransmission)
+		return Priority::Retransmission;
+
+	if (message.size() < 12) // RTP header
+		return Priority::Video;
+
+	auto rtp = reinterpret_cast<const RTP *>(message.data());
+	int payloadType = rtp->payloadType();
+	auto contains = [payloadType](const std::vector<int> &v) {
+		return std::find(v.begin(), v.end(), payloadType) != v.end();
+	};
+
+	if (contains(mRtxPayloadTypes))
+		return Priority::Retransmission;
+
+	if (contains(mFecPayloadTypes))
+		return Priority::Padding;
+
+	if (rtp->padding()) {
+		// Check if the packet only contains padding, for instance for bandwidth probing
+		size_t headerSize = rtp->getSize();
+		if (rtp->extension() && message.size() >= headerSize + 4) {
+			// The extension header contains its length in 32-bit words
+			size_t extensionLength = std::to_integer<size_t>(message[headerSize + 2]) << 8 |
+			                         std::to_integer<size_t>(message[headerSize + 3]);
+			headerSize += 4 + 4 * extensionLength;
+		}
+		size_t paddingSize = std::to_integer<size_t>(message.back());
+		if (headerSize + paddingSize >= message.size())
+			return Priority::Padding;
+	}
+
+	return Priority::Video;
+}
+#endif
+
 void Track::setMediaHandler(shared_ptr<MediaHandler> handler) {
 	{
 		std::unique_lock lock(mMutex);
@@ -24,6 +24,7 @@
 #include "description.hpp"
 #include "mediahandler.hpp"
 #include "queue.hpp"
+#include "ring.hpp"
 
 #if RTC_ENABLE_MEDIA
 #include "dtlssrtptransport.hpp"
@@ -31,6 +32,7 @@
 
 #include <atomic>
 #include <shared_mutex>
+#include <vector>
 
 namespace rtc::impl {
 
@@ -67,6 +69,11 @@ public:
 
 private:
 	bool transportSend(message_ptr message);
+	void updatePayloadTypes();
+
+#if RTC_ENABLE_MEDIA
+	DtlsSrtpTransport::Priority sendPriority(const Message &message) const;
+#endif
 
 	const weak_ptr<PeerConnection> mPeerConnection;
 #if RTC_ENABLE_MEDIA
@@ -74,6 +81,7 @@ private:
 #endif
 
 	Description::Media mMediaDescription;
+	std::vector<int> mRtxPayloadTypes, mFecPayloadTypes; // from the description
 	shared_ptr<MediaHandler> mMediaHandler;
 
 	mutable std::shared_mutex mMutex;
@@ -81,6 +89,7 @@ private:
 	std::atomic<bool> mIsClosed = false;
 
 	Queue<message_ptr> mRecvQueue;
+	std::unique_ptr<Ring<message_ptr>> mPollQueue; // replaces mRecvQueue in busy-polling mode
 };
 
 } // namespace rtc::impl
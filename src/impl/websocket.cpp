@@ -383,11 +383,12 @@ void WebSocket::closeTransports() {
 	// Reset callbacks now that state is changed
 	resetCallbacks();
 
-	// Pass the pointers to a thread, allowing to terminate a transport from its own thread
+	// Pass the pointers to a teardown thread, allowing to terminate a transport from its own thread
+	// without blocking workers of the global thread pool
 	auto ws = std::atomic_exchange(&mWsTransport, decltype(mWsTransport)(nullptr));
 	auto tls = std::atomic_exchange(&mTlsTransport, decltype(mTlsTransport)(nullptr));
 	auto tcp = std::atomic_exchange(&mTcpTransport, decltype(mTcpTransport)(nullptr));
-	ThreadPool::Instance().enqueue([ws, tls, tcp]() mutable {
+	ThreadPool::TearDownInstance().enqueue([ws, tls, tcp]() mutable {
 		if (ws)
 			ws->stop();
 		if (tls)
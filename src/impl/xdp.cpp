@@ -0,0 +1,432 @@
+/**
+ * Copyright (c) 2021 Paul-Louis Ageneau
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "xdp.hpp"
+#include "logcounter.hpp"
+#include "socket.hpp"
+
+#ifndef NO_XDP
+
+#include <linux/if_ether.h>
+#include <linux/if_link.h>
+#include <net/if.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+namespace rtc::impl {
+
+static LogCounter COUNTER_XDP_BAD_FRAME(plog::warning,
+                                        "Number of invalid frames dropped by AF_XDP receivers");
+
+namespace {
+
+const uint32_t FrameSize = 2048; // UMEM chunk size, large enough for a non-jumbo frame
+
+long bpf(int cmd, union bpf_attr *attr) { return ::syscall(__NR_bpf, cmd, attr, sizeof(*attr)); }
+
+struct bpf_insn insn(uint8_t code, uint8_t dst, uint8_t src, int16_t off, int32_t imm) {
+	struct bpf_insn i = {};
+	i.code = code;
+	i.dst_reg = dst & 0x0F;
+	i.src_reg = src & 0x0F;
+	i.off = off;
+	i.imm = imm;
+	return i;
+}
+
+// Returns the UDP payload of an Ethernet frame, or an empty range if it is not a UDP datagram
+std::pair<const byte *, size_t> udp_payload(const byte *frame, size_t len) {
+	const auto u8 = [frame](size_t offset) { return std::to_integer<uint8_t>(frame[offset]); };
+	const auto u16 = [&u8](size_t offset) { return uint16_t(u8(offset) << 8 | u8(offset + 1)); };
+
+	if (len < ETH_HLEN)
+		return {nullptr, 0};
+
+	size_t offset = ETH_HLEN;
+	switch (u16(12)) {
+	case ETH_P_IP: {
+		if (len < offset + 20 || (u8(offset) >> 4) != 4 || u8(offset + 9) != IPPROTO_UDP)
+			return {nullptr, 0};
+
+		size_t headerLen = size_t(u8(offset) & 0x0F) * 4;
+		size_t totalLen = u16(offset + 2);
+		if (headerLen < 20 || totalLen < headerLen || len < offset + totalLen)
+			return {nullptr, 0};
+
+		len = offset + totalLen; // strip Ethernet padding
+		offset += headerLen;
+		break;
+	}
+	case ETH_P_IPV6: {
+		// Extension headers are not handled, the XDP program does not redirect them
+		if (len < offset + 40 || u8(offset + 6) != IPPROTO_UDP)
+			return {nullptr, 0};
+
+		size_t payloadLen = u16(offset + 4);
+		if (len < offset + 40 + payloadLen)
+			return {nullptr, 0};
+
+		len = offset + 40 + payloadLen;
+		offset += 40;
+		break;
+	}
+	default:
+		return {nullptr, 0};
+	}
+
+	if (len < offset + 8)
+		return {nullptr, 0};
+
+	size_t udpLen = u16(offset + 4);
+	if (udpLen < 8 || len < offset + udpLen)
+		return {nullptr, 0};
+
+	return {frame + offset + 8, udpLen - 8};
+}
+
+} // namespace
+
+XdpReceiver::XdpReceiver(const string &interfaceName, unsigned int queue,
+                         const struct sockaddr *bindAddr, unsigned int framesCount) {
+	int ifindex = int(::if_nametoindex(interfaceName.c_str()));
+	if (ifindex == 0)
+		throw std::invalid_argument("Unknown interface: " + interfaceName);
+
+	// Rings need a power of two entries
+	unsigned int entries = 64;
+	while (entries < framesCount && entries < 65536)
+		entries <<= 1;
+
+	try {
+		createMap(queue);
+		loadProgram(bindAddr);
+		createSocket(ifindex, queue, entries);
+		attach(ifindex);
+
+	} catch (...) {
+		close();
+		throw;
+	}
+}
+
+XdpReceiver::~XdpReceiver() { close(); }
+
+int XdpReceiver::process(const std::function<void(message_ptr)> &callback) {
+	uint32_t consumer = *mRxConsumer;
+	uint32_t producer = __atomic_load_n(mRxProducer, __ATOMIC_ACQUIRE);
+	uint32_t fillProducer = *mFillProducer;
+	int count = 0;
+	for (; consumer != producer; ++consumer) {
+		const struct xdp_desc &desc = mRxDescs[consumer & mRxMask];
+		const byte *frame = static_cast<const byte *>(mUmem) + desc.addr;
+		auto [payload, len] = udp_payload(frame, desc.len);
+
+		// The frame can be given back to the kernel once the payload is copied
+		message_ptr message = payload ? make_message(payload, payload + len) : nullptr;
+		mFillAddrs[fillProducer++ & mFillMask] = desc.addr & ~uint64_t(FrameSize - 1);
+
+		if (!message) {
+			COUNTER_XDP_BAD_FRAME++;
+			continue;
+		}
+
+		callback(std::move(message));
+		++count;
+	}
+
+	__atomic_store_n(mRxConsumer, consumer, __ATOMIC_RELEASE);
+	__atomic_store_n(mFillProducer, fillProducer, __ATOMIC_RELEASE);
+	return count;
+}
+
+void XdpReceiver::close() {
+	// Detach the program first so traffic goes back to the kernel
+	if (mLinkFd >= 0)
+		::close(mLinkFd);
+	if (mSock >= 0)
+		::close(mSock);
+	if (mProgFd >= 0)
+		::close(mProgFd);
+	if (mMapFd >= 0)
+		::close(mMapFd);
+	if (mRxRing)
+		::munmap(mRxRing, mRxRingSize);
+	if (mFillRing)
+		::munmap(mFillRing, mFillRingSize);
+	if (mUmem)
+		::munmap(mUmem, mUmemSize);
+
+	mLinkFd = mSock = mProgFd = mMapFd = -1;
+	mRxRing = mFillRing = mUmem = nullptr;
+}
+
+void XdpReceiver::createMap(unsigned int queue) {
+	union bpf_attr attr = {};
+	attr.map_type = BPF_MAP_TYPE_XSKMAP;
+	attr.key_size = sizeof(uint32_t);
+	attr.value_size = sizeof(uint32_t);
+	attr.max_entries = queue + 1;
+	mMapFd = int(bpf(BPF_MAP_CREATE, &attr));
+	if (mMapFd < 0)
+		throw std::runtime_error("XDP socket map creation failed, errno=" + std::to_string(errno));
+}
+
+void XdpReceiver::loadProgram(const struct sockaddr *bindAddr) {
+	// Fields are compared as loaded from the packet, hence in network byte order
+	uint16_t port;
+	optional<uint32_t> ipv4;                // destination address, none for any
+	optional<std::array<uint32_t, 4>> ipv6; // destination address, none for any
+	bool acceptIpv4 = true, acceptIpv6 = true;
+	switch (bindAddr->sa_family) {
+	case AF_INET: {
+		auto sin = reinterpret_cast<const struct sockaddr_in *>(bindAddr);
+		port = sin->sin_port;
+		if (sin->sin_addr.s_addr != htonl(INADDR_ANY))
+			ipv4 = sin->sin_addr.s_addr;
+
+		acceptIpv6 = false;
+		break;
+	}
+	case AF_INET6: {
+		auto sin6 = reinterpret_cast<const struct sockaddr_in6 *>(bindAddr);
+		port = sin6->sin6_port;
+		if (IN6_IS_ADDR_V4MAPPED(&sin6->sin6_addr)) {
+			uint32_t addr;
+			std::memcpy(&addr, sin6->sin6_addr.s6_addr + 12, sizeof(addr));
+			ipv4 = addr;
+			acceptIpv6 = false;
+		} else if (!IN6_IS_ADDR_UNSPECIFIED(&sin6->sin6_addr)) {
+			std::array<uint32_t, 4> addr;
+			std::memcpy(addr.data(), sin6->sin6_addr.s6_addr, sizeof(addr));
+			ipv6 = addr;
+			acceptIpv4 = false;
+		}
+		break;
+	}
+	default:
+		throw std::invalid_argument("Unknown address family");
+	}
+
+	enum Label { Pass, Ipv6, Redirect, LabelsCount };
+	std::vector<struct bpf_insn> prog;
+	std::vector<std::pair<size_t, Label>> fixups;
+	size_t labels[LabelsCount] = {};
+
+	const auto emit = [&prog](struct bpf_insn i) { prog.push_back(i); };
+	const auto label = [&prog, &labels](Label l) { labels[l] = prog.size(); };
+	const auto jump = [&](uint8_t op, uint8_t dst, int32_t imm, Label target) {
+		fixups.emplace_back(prog.size(), target);
+		emit(insn(BPF_JMP | op | BPF_K, dst, 0, 0, imm));
+	};
+	const auto jump32 = [&](uint8_t op, uint8_t dst, uint32_t imm, Label target) {
+		// 32-bit comparison, as the immediate would be sign-extended against the 64-bit register
+		fixups.emplace_back(prog.size(), target);
+		emit(insn(BPF_JMP32 | op | BPF_K, dst, 0, 0, int32_t(imm)));
+	};
+	const auto load = [&](uint8_t size, uint8_t dst, uint8_t src, int16_t off) {
+		emit(insn(BPF_LDX | BPF_MEM | size, dst, src, off, 0));
+	};
+	const auto bound = [&](int32_t len) { // r4 = data + len, pass if beyond data_end
+		emit(insn(BPF_ALU64 | BPF_MOV | BPF_X, BPF_REG_4, BPF_REG_2, 0, 0));
+		emit(insn(BPF_ALU64 | BPF_ADD | BPF_K, BPF_REG_4, 0, 0, len));
+		fixups.emplace_back(prog.size(), Pass);
+		emit(insn(BPF_JMP | BPF_JGT | BPF_X, BPF_REG_4, BPF_REG_3, 0, 0));
+	};
+
+	emit(insn(BPF_ALU64 | BPF_MOV | BPF_X, BPF_REG_6, BPF_REG_1, 0, 0));
+	load(BPF_W, BPF_REG_2, BPF_REG_6, offsetof(struct xdp_md, data));
+	load(BPF_W, BPF_REG_3, BPF_REG_6, offsetof(struct xdp_md, data_end));
+	bound(ETH_HLEN);
+	load(BPF_H, BPF_REG_5, BPF_REG_2, 12);
+	jump(BPF_JEQ, BPF_REG_5, htons(ETH_P_IPV6), Ipv6);
+	jump(BPF_JNE, BPF_REG_5, htons(ETH_P_IP), Pass);
+
+	// IPv4 without options, fragments are left to the kernel
+	if (acceptIpv4) {
+		bound(ETH_HLEN + 20 + 8);
+		load(BPF_B, BPF_REG_5, BPF_REG_2, ETH_HLEN);
+		jump(BPF_JNE, BPF_REG_5, 0x45, Pass);
+		load(BPF_B, BPF_REG_5, BPF_REG_2, ETH_HLEN + 9);
+		jump(BPF_JNE, BPF_REG_5, IPPROTO_UDP, Pass);
+		load(BPF_H, BPF_REG_5, BPF_REG_2, ETH_HLEN + 6);
+		emit(insn(BPF_ALU64 | BPF_AND | BPF_K, BPF_REG_5, 0, 0, htons(0x3FFF)));
+		jump(BPF_JNE, BPF_REG_5, 0, Pass);
+		load(BPF_H, BPF_REG_5, BPF_REG_2, ETH_HLEN + 20 + 2);
+		jump(BPF_JNE, BPF_REG_5, port, Pass);
+		if (ipv4) {
+			load(BPF_W, BPF_REG_5, BPF_REG_2, ETH_HLEN + 16);
+			jump32(BPF_JNE, BPF_REG_5, *ipv4, Pass);
+		}
+		jump(BPF_JA, 0, 0, Redirect);
+	} else {
+		jump(BPF_JA, 0, 0, Pass);
+	}
+
+	// IPv6 without extension headers
+	label(Ipv6);
+	if (acceptIpv6) {
+		bound(ETH_HLEN + 40 + 8);
+		load(BPF_B, BPF_REG_5, BPF_REG_2, ETH_HLEN + 6);
+		jump(BPF_JNE, BPF_REG_5, IPPROTO_UDP, Pass);
+		load(BPF_H, BPF_REG_5, BPF_REG_2, ETH_HLEN + 40 + 2);
+		jump(BPF_JNE, BPF_REG_5, port, Pass);
+		if (ipv6) {
+			for (int i = 0; i < 4; ++i) {
+				load(BPF_W, BPF_REG_5, BPF_REG_2, int16_t(ETH_HLEN + 24 + 4 * i));
+				jump32(BPF_JNE, BPF_REG_5, (*ipv6)[i], Pass);
+			}
+		}
+	} else {
+		jump(BPF_JA, 0, 0, Pass);
+	}
+
+	// Redirect to the socket bound to the queue, or pass if there is none
+	label(Redirect);
+	load(BPF_W, BPF_REG_2, BPF_REG_6, offsetof(struct xdp_md, rx_queue_index));
+	emit(insn(BPF_LD | BPF_DW | BPF_IMM, BPF_REG_1, BPF_PSEUDO_MAP_FD, 0, mMapFd));
+	emit(insn(0, 0, 0, 0, 0));
+	emit(insn(BPF_ALU64 | BPF_MOV | BPF_K, BPF_REG_3, 0, 0, XDP_PASS));
+	emit(insn(BPF_JMP | BPF_CALL, 0, 0, 0, BPF_FUNC_redirect_map));
+	emit(insn(BPF_JMP | BPF_EXIT, 0, 0, 0, 0));
+
+	label(Pass);
+	emit(insn(BPF_ALU64 | BPF_MOV | BPF_K, BPF_REG_0, 0, 0, XDP_PASS));
+	emit(insn(BPF_JMP | BPF_EXIT, 0, 0, 0, 0));
+
+	for (auto [index, target] : fixups)
+		prog[index].off = int16_t(labels[target] - index - 1);
+
+	union bpf_attr attr = {};
+	attr.prog_type = BPF_PROG_TYPE_XDP;
+	attr.insns = reinterpret_cast<uintptr_t>(prog.data());
+	attr.insn_cnt = uint32_t(prog.size());
+	attr.license = reinterpret_cast<uintptr_t>("Dual BSD/GPL");
+	mProgFd = int(bpf(BPF_PROG_LOAD, &attr));
+	if (mProgFd < 0)
+		throw std::runtime_error("XDP program loading failed, errno=" + std::to_string(errno));
+}
+
+void XdpReceiver::createSocket(int ifindex, unsigned int queue, unsigned int entries) {
+	mSock = ::socket(AF_XDP, SOCK_RAW, 0);
+	if (mSock < 0)
+		throw std::runtime_error("AF_XDP socket creation failed, errno=" + std::to_string(errno));
+
+	mUmemSize = size_t(entries) * FrameSize;
+	mUmem = ::mmap(nullptr, mUmemSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (mUmem == MAP_FAILED) {
+		mUmem = nullptr;
+		throw std::runtime_error("UMEM allocation failed");
+	}
+
+	struct xdp_umem_reg reg = {};
+	reg.addr = reinterpret_cast<uintptr_t>(mUmem);
+	reg.len = mUmemSize;
+	reg.chunk_size = FrameSize;
+	if (::setsockopt(mSock, SOL_XDP, XDP_UMEM_REG, &reg, sizeof(reg)) < 0)
+		throw std::runtime_error("UMEM registration failed, errno=" + std::to_string(errno));
+
+	// The completion ring is mandatory even though nothing is sent
+	const int completionEntries = 64;
+	if (::setsockopt(mSock, SOL_XDP, XDP_UMEM_FILL_RING, &entries, sizeof(entries)) < 0 ||
+	    ::setsockopt(mSock, SOL_XDP, XDP_UMEM_COMPLETION_RING, &completionEntries,
+	                 sizeof(completionEntries)) < 0 ||
+	    ::setsockopt(mSock, SOL_XDP, XDP_RX_RING, &entries, sizeof(entries)) < 0)
+		throw std::runtime_error("AF_XDP ring setup failed, errno=" + std::to_string(errno));
+
+	struct xdp_mmap_offsets off = {};
+	socklen_t optlen = sizeof(off);
+	if (::getsockopt(mSock, SOL_XDP, XDP_MMAP_OFFSETS, &off, &optlen) < 0)
+		throw std::runtime_error("AF_XDP ring offsets query failed, errno=" +
+		                         std::to_string(errno));
+
+	mRxRingSize = off.rx.desc + entries * sizeof(struct xdp_desc);
+	mRxRing = ::mmap(nullptr, mRxRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, mSock,
+	                 XDP_PGOFF_RX_RING);
+	if (mRxRing == MAP_FAILED) {
+		mRxRing = nullptr;
+		throw std::runtime_error("AF_XDP receive ring mapping failed");
+	}
+
+	mFillRingSize = off.fr.desc + entries * sizeof(uint64_t);
+	mFillRing = ::mmap(nullptr, mFillRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+	                   mSock, XDP_UMEM_PGOFF_FILL_RING);
+	if (mFillRing == MAP_FAILED) {
+		mFillRing = nullptr;
+		throw std::runtime_error("AF_XDP fill ring mapping failed");
+	}
+
+	auto rx = static_cast<char *>(mRxRing);
+	mRxProducer = reinterpret_cast<uint32_t *>(rx + off.rx.producer);
+	mRxConsumer = reinterpret_cast<uint32_t *>(rx + off.rx.consumer);
+	mRxDescs = reinterpret_cast<struct xdp_desc *>(rx + off.rx.desc);
+	mRxMask = entries - 1;
+
+	auto fill = static_cast<char *>(mFillRing);
+	mFillProducer = reinterpret_cast<uint32_t *>(fill + off.fr.producer);
+	mFillAddrs = reinterpret_cast<uint64_t *>(fill + off.fr.desc);
+	mFillMask = entries - 1;
+
+	// Give all frames to the kernel
+	for (uint32_t i = 0; i < entries; ++i)
+		mFillAddrs[i] = uint64_t(i) * FrameSize;
+	__atomic_store_n(mFillProducer, entries, __ATOMIC_RELEASE);
+
+	struct sockaddr_xdp addr = {};
+	addr.sxdp_family = AF_XDP;
+	addr.sxdp_ifindex = uint32_t(ifindex);
+	addr.sxdp_queue_id = queue;
+	if (::bind(mSock, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) < 0)
+		throw std::runtime_error("AF_XDP socket binding failed, errno=" + std::to_string(errno));
+
+	union bpf_attr attr = {};
+	uint32_t key = queue;
+	uint32_t value = uint32_t(mSock);
+	attr.map_fd = uint32_t(mMapFd);
+	attr.key = reinterpret_cast<uintptr_t>(&key);
+	attr.value = reinterpret_cast<uintptr_t>(&value);
+	if (bpf(BPF_MAP_UPDATE_ELEM, &attr) < 0)
+		throw std::runtime_error("XDP socket map update failed, errno=" + std::to_string(errno));
+}
+
+void XdpReceiver::attach(int ifindex) {
+	// Try driver mode first, then generic mode which works with any interface
+	for (uint32_t flags : {0u, uint32_t(XDP_FLAGS_SKB_MODE)}) {
+		union bpf_attr attr = {};
+		attr.link_create.prog_fd = uint32_t(mProgFd);
+		attr.link_create.target_ifindex = uint32_t(ifindex);
+		attr.link_create.attach_type = BPF_XDP;
+		attr.link_create.flags = flags;
+		mLinkFd = int(bpf(BPF_LINK_CREATE, &attr));
+		if (mLinkFd >= 0) {
+			PLOG_DEBUG << "XDP program attached in " << (flags ? "generic" : "driver") << " mode";
+			return;
+		}
+	}
+
+	throw std::runtime_error("XDP program attachment failed, errno=" + std::to_string(errno));
+}
+
+} // namespace rtc::impl
+
+#endif
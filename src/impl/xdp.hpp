@@ -0,0 +1,84 @@
+/**
+ * Copyright (c) 2021 Paul-Louis Ageneau
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef RTC_IMPL_XDP_H
+#define RTC_IMPL_XDP_H
+
+#include "common.hpp"
+#include "message.hpp"
+#include "socket.hpp"
+
+#if defined(__linux__) && __has_include(<linux/if_xdp.h>) && __has_include(<linux/bpf.h>)
+#include <linux/bpf.h>
+#include <linux/if_xdp.h>
+#endif
+
+#ifndef BPF_F_XDP_HAS_FRAGS // XDP links require Linux 5.9, check for 5.18 headers
+#define NO_XDP
+#endif
+
+#ifndef NO_XDP
+
+#include <functional>
+
+namespace rtc::impl {
+
+// Datagram receiver using an AF_XDP socket. An XDP program redirects UDP datagrams to the bound
+// address and port arriving on the interface queue to the socket, bypassing the kernel network
+// stack. A wildcard address matches any destination of its family, and the IPv6 one also matches
+// IPv4 like a dual-stack socket. Any other traffic is passed to the kernel as usual. Requires
+// CAP_NET_ADMIN, CAP_NET_RAW, and CAP_BPF.
+class XdpReceiver final {
+public:
+	// Throws if AF_XDP is unavailable or the program can't be attached
+	XdpReceiver(const string &interfaceName, unsigned int queue, const struct sockaddr *bindAddr,
+	            unsigned int framesCount);
+	~XdpReceiver();
+
+	int fd() const { return mSock; } // readable when frames are pending
+
+	// Processes received frames, returns the number of received datagrams
+	int process(const std::function<void(message_ptr)> &callback);
+
+private:
+	void close();
+	void createMap(unsigned int queue);
+	void loadProgram(const struct sockaddr *bindAddr);
+	void createSocket(int ifindex, unsigned int queue, unsigned int entries);
+	void attach(int ifindex);
+
+	int mMapFd = -1;
+	int mProgFd = -1;
+	int mSock = -1;
+	int mLinkFd = -1;
+
+	void *mUmem = nullptr;
+	size_t mUmemSize = 0;
+	void *mRxRing = nullptr, *mFillRing = nullptr;
+	size_t mRxRingSize = 0, mFillRingSize = 0;
+	uint32_t *mRxProducer = nullptr, *mRxConsumer = nullptr, mRxMask = 0;
+	struct xdp_desc *mRxDescs = nullptr;
+	uint32_t *mFillProducer = nullptr, mFillMask = 0;
+	uint64_t *mFillAddrs = nullptr;
+};
+
+} // namespace rtc::impl
+
+#endif
+
+#endif
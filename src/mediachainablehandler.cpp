@@ -48,7 +48,10 @@ bool MediaChainableHandler::sendProduct(ChainedOutgoingProduct product) {
 			if (!message) {
 				LOG_DEBUG << "Invalid message to send " << i + 1 << "/" << messages->size();
 			}
-			auto sendResult = send(make_message(*message));
+			// Media generated on incoming messages is retransmitted, e.g. on NACK
+			auto retransmitted = make_message(*message);
+			retransmitted->retransmission = true;
+			auto sendResult = send(retransmitted);
 			if (!sendResult) {
 				LOG_DEBUG << "Failed to send message " << i + 1 << "/" << messages->size();
 			}
@@ -43,6 +43,27 @@ using namespace std::placeholders;
 
 namespace rtc {
 
+namespace {
+
+// Opens the new channels if already connected and triggers the negotiation
+void startDataChannels(PeerConnection &pc, impl::PeerConnection &pcImpl,
+                       const std::vector<shared_ptr<impl::DataChannel>> &channelImpls) {
+	if (auto transport = pcImpl.getSctpTransport())
+		if (transport->state() == impl::SctpTransport::State::Connected)
+			for (auto &channelImpl : channelImpls)
+				channelImpl->open(transport);
+
+	// Renegotiation is needed iff the current local description does not have application
+	auto local = pcImpl.localDescription();
+	if (!local || !local->hasApplication())
+		pcImpl.negotiationNeeded = true;
+
+	if (!pcImpl.config.disableAutoNegotiation)
+		pc.setLocalDescription();
+}
+
+} // namespace
+
 PeerConnection::PeerConnection() : PeerConnection(Configuration()) {}
 
 PeerConnection::PeerConnection(Configuration config)
@@ -248,20 +269,24 @@ optional<string> PeerConnection::remoteAddress() const {
 shared_ptr<DataChannel> PeerConnection::createDataChannel(string label, DataChannelInit init) {
 	auto channelImpl = impl()->emplaceDataChannel(std::move(label), std::move(init));
 	auto channel = std::make_shared<DataChannel>(channelImpl);
+	startDataChannels(*this, *impl(), {channelImpl});
+	return channel;
+}
 
-	if (auto transport = impl()->getSctpTransport())
-		if (transport->state() == impl::SctpTransport::State::Connected)
-			channelImpl->open(transport);
+std::vector<shared_ptr<DataChannel>>
+PeerConnection::createDataChannels(std::vector<string> labels, DataChannelInit init) {
+	if (labels.empty())
+		return {};
 
-	// Renegotiation is needed iff the current local description does not have application
-	auto local = impl()->localDescription();
-	if (!local || !local->hasApplication())
-		impl()->negotiationNeeded = true;
+	auto channelImpls = impl()->emplaceDataChannels(std::move(labels), std::move(init));
 
-	if (!impl()->config.disableAutoNegotiation)
-		setLocalDescription();
+	std::vector<shared_ptr<DataChannel>> channels;
+	channels.reserve(channelImpls.size());
+	for (auto &channelImpl : channelImpls)
+		channels.push_back(std::make_shared<DataChannel>(channelImpl));
 
-	return channel;
+	startDataChannels(*this, *impl(), channelImpls);
+	return channels;
 }
 
 void PeerConnection::onDataChannel(
@@ -310,6 +335,8 @@ bool PeerConnection::getSelectedCandidatePair(Candidate *local, Candidate *remot
 	return iceTransport ? iceTransport->getSelectedCandidatePair(local, remote) : false;
 }
 
+bool PeerConnection::poll() { return impl()->poll(); }
+
 void PeerConnection::clearStats() {
 	if (auto sctpTransport = impl()->getSctpTransport())
 		return sctpTransport->clearStats();
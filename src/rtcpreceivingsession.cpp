@@ -25,6 +25,7 @@
 #include "impl/logcounter.hpp"
 
 #include <cmath>
+#include <cstdlib>
 #include <utility>
 
 #ifdef _WIN32
@@ -42,6 +43,8 @@ static impl::LogCounter COUNTER_BAD_NOTIF_LEN(plog::warning,
 static impl::LogCounter COUNTER_BAD_SCTP_STATUS(plog::warning,
                                                 "Number of unknown SCTP_STATUS errors");
 
+RtcpReceivingSession::RtcpReceivingSession(uint32_t clockRate) : mClockRate(clockRate) {}
+
 message_ptr RtcpReceivingSession::outgoing(message_ptr ptr) { return ptr; }
 
 message_ptr RtcpReceivingSession::incoming(message_ptr ptr) {
@@ -66,6 +69,21 @@ message_ptr RtcpReceivingSession::incoming(message_ptr ptr) {
 
 		mSsrc = rtp->ssrc();
 
+		if (!mHasSeqNo || rtp->ssrc() != mMediaSsrc) {
+			mMediaSsrc = rtp->ssrc();
+			mHasSeqNo = true;
+			mGreatestSeqNo = rtp->seqNumber();
+			mHasTransit = false;
+			mJitter = 0;
+		} else if (int16_t(rtp->seqNumber() - uint16_t(mGreatestSeqNo)) > 0) {
+			mGreatestSeqNo = rtp->seqNumber();
+		}
+
+		// Messages injected locally have no arrival time
+		updateJitter(rtp, ptr->arrival != std::chrono::steady_clock::time_point{}
+		                      ? ptr->arrival
+		                      : std::chrono::steady_clock::now());
+
 		return ptr;
 	}
 
@@ -81,16 +99,36 @@ message_ptr RtcpReceivingSession::incoming(message_ptr ptr) {
 		auto sr = reinterpret_cast<const RTCP_SR *>(ptr->data());
 		mSyncRTPTS = sr->rtpTimestamp();
 		mSyncNTPTS = sr->ntpTimestamp();
+		mLastSRArrival = ptr->arrival != std::chrono::steady_clock::time_point{}
+		                     ? ptr->arrival
+		                     : std::chrono::steady_clock::now();
 		sr->log();
 
 		// TODO For the time being, we will send RR's/REMB's when we get an SR
-		pushRR(0);
-		if (mRequestedBitrate > 0)
-			pushREMB(mRequestedBitrate);
+		pushFeedback(lastSRDelay(),
+		             mRequestedBitrate > 0 ? std::make_optional(mRequestedBitrate) : nullopt);
 	}
 	return nullptr;
 }
 
+void RtcpReceivingSession::updateJitter(const RTP *rtp,
+                                        std::chrono::steady_clock::time_point arrival) {
+	if (mClockRate == 0)
+		return;
+
+	// Convert the arrival time to RTP timestamp units, the origin does not matter and differences
+	// are computed modulo 2^32 like RTP timestamps
+	using std::chrono::microseconds;
+	auto us = std::chrono::duration_cast<microseconds>(arrival.time_since_epoch()).count();
+	uint32_t transit = uint32_t(int64_t(us) * mClockRate / 1000000) - rtp->timestamp();
+	if (mHasTransit) {
+		int32_t d = int32_t(transit - mLastTransit);
+		mJitter += uint32_t(std::abs(int64_t(d))) - ((mJitter + 8) >> 4);
+	}
+	mLastTransit = transit;
+	mHasTransit = true;
+}
+
 void RtcpReceivingSession::requestBitrate(unsigned int newBitrate) {
 	mRequestedBitrate = newBitrate;
 
@@ -98,22 +136,63 @@ void RtcpReceivingSession::requestBitrate(unsigned int newBitrate) {
 	pushREMB(newBitrate);
 }
 
-void RtcpReceivingSession::pushREMB(unsigned int bitrate) {
-	message_ptr msg = make_message(RTCP_REMB::SizeWithSSRCs(1), Message::Type::Control);
-	auto remb = reinterpret_cast<RTCP_REMB *>(msg->data());
-	remb->preparePacket(mSsrc, 1, bitrate);
-	remb->setSsrc(0, mSsrc);
+void RtcpReceivingSession::pushREMB(unsigned int bitrate) { pushFeedback(nullopt, bitrate); }
 
-	send(msg);
+void RtcpReceivingSession::pushRR(unsigned int lastSR_delay) {
+	pushFeedback(lastSR_delay, nullopt);
 }
 
-void RtcpReceivingSession::pushRR(unsigned int lastSR_delay) {
-	auto msg = make_message(RTCP_RR::SizeWithReportBlocks(1), Message::Type::Control);
-	auto rr = reinterpret_cast<RTCP_RR *>(msg->data());
-	rr->preparePacket(mSsrc, 1);
-	rr->getReportBlock(0)->preparePacket(mSsrc, 0, 0, uint16_t(mGreatestSeqNo), 0, 0, mSyncNTPTS,
-	                                     lastSR_delay);
-	rr->log();
+unsigned int RtcpReceivingSession::lastSRDelay() const {
+	if (!mLastSRArrival)
+		return 0;
+
+	using std::chrono::microseconds;
+	auto elapsed = std::chrono::steady_clock::now() - *mLastSRArrival;
+	return unsigned(std::chrono::duration_cast<microseconds>(elapsed).count() * 65536 / 1000000);
+}
+
+void RtcpReceivingSession::pushFeedback(optional<unsigned int> lastSR_delay,
+                                        optional<unsigned int> bitrate, bool pli) {
+	// Per RFC 4585, feedback is sent in a compound packet starting with a report, so REMB and PLI
+	// carry an RR whenever there is something to report
+	if (!lastSR_delay && (bitrate || pli) && (mHasSeqNo || mLastSRArrival))
+		lastSR_delay = lastSRDelay();
+
+	// Compute the size first so the message is allocated once, then write packets in place
+	size_t size = 0;
+	if (lastSR_delay)
+		size += RTCP_RR::SizeWithReportBlocks(1);
+	if (bitrate)
+		size += RTCP_REMB::SizeWithSSRCs(1);
+	if (pli)
+		size += RTCP_PLI::Size();
+
+	if (size == 0)
+		return;
+
+	auto msg = make_message(size, Message::Type::Control);
+	byte *p = msg->data();
+
+	if (lastSR_delay) {
+		auto rr = reinterpret_cast<RTCP_RR *>(p);
+		rr->preparePacket(mSsrc, 1);
+		rr->getReportBlock(0)->preparePacket(mSsrc, 0, 0, uint16_t(mGreatestSeqNo), 0,
+		                                     mJitter >> 4, mSyncNTPTS, *lastSR_delay);
+		rr->log();
+		p += RTCP_RR::SizeWithReportBlocks(1);
+	}
+
+	if (bitrate) {
+		auto remb = reinterpret_cast<RTCP_REMB *>(p);
+		remb->preparePacket(mSsrc, 1, *bitrate);
+		remb->setSsrc(0, mSsrc);
+		p += RTCP_REMB::SizeWithSSRCs(1);
+	}
+
+	if (pli) {
+		auto pliPacket = reinterpret_cast<RTCP_PLI *>(p);
+		pliPacket->preparePacket(mSsrc);
+	}
 
 	send(msg);
 }
@@ -133,12 +212,7 @@ bool RtcpReceivingSession::requestKeyframe() {
 	return true; // TODO Make this false when it is impossible (i.e. Opus).
 }
 
-void RtcpReceivingSession::pushPLI() {
-	auto msg = make_message(RTCP_PLI::Size(), Message::Type::Control);
-	auto *pli = reinterpret_cast<RTCP_PLI *>(msg->data());
-	pli->preparePacket(mSsrc);
-	send(msg);
-}
+void RtcpReceivingSession::pushPLI() { pushFeedback(nullopt, nullopt, true); }
 
 } // namespace rtc
 
@@ -29,11 +29,13 @@ ChainedOutgoingProduct RtcpSrReporter::processOutgoingBinaryMessage(ChainedMessa
                                                                     message_ptr control) {
 	if (needsToReport) {
 		auto timestamp = rtpConfig->timestamp;
-		auto sr = getSenderReport(timestamp);
 		if (control) {
-			control->insert(control->end(), sr->begin(), sr->end());
+			// Append to the pending control message to send a single compound packet
+			size_t offset = control->size();
+			control->resize(offset + senderReportSize());
+			writeSenderReport(control->data() + offset, timestamp);
 		} else {
-			control = sr;
+			control = getSenderReport(timestamp);
 		}
 		needsToReport = false;
 	}
@@ -65,10 +67,18 @@ uint64_t RtcpSrReporter::secondsToNTP(double seconds) {
 void RtcpSrReporter::setNeedsToReport() { needsToReport = true; }
 
 message_ptr RtcpSrReporter::getSenderReport(uint32_t timestamp) {
+	auto msg = make_message(senderReportSize(), Message::Type::Control);
+	writeSenderReport(msg->data(), timestamp);
+	return msg;
+}
+
+size_t RtcpSrReporter::senderReportSize() const {
+	return RTCP_SR::Size(0) + RTCP_SDES::Size({{uint8_t(rtpConfig->cname.size())}});
+}
+
+void RtcpSrReporter::writeSenderReport(byte *data, uint32_t timestamp) {
 	auto srSize = RTCP_SR::Size(0);
-	auto msg = make_message(srSize + RTCP_SDES::Size({{uint8_t(rtpConfig->cname.size())}}),
-	                        Message::Type::Control);
-	auto sr = reinterpret_cast<RTCP_SR *>(msg->data());
+	auto sr = reinterpret_cast<RTCP_SR *>(data);
 	auto timestamp_s = rtpConfig->timestampToSeconds(timestamp);
 	auto currentTime = timeOffset + timestamp_s;
 	sr->setNtpTimestamp(secondsToNTP(currentTime));
@@ -77,7 +87,7 @@ message_ptr RtcpSrReporter::getSenderReport(uint32_t timestamp) {
 	sr->setOctetCount(payloadOctets);
 	sr->preparePacket(rtpConfig->ssrc, 0);
 
-	auto sdes = reinterpret_cast<RTCP_SDES *>(msg->data() + srSize);
+	auto sdes = reinterpret_cast<RTCP_SDES *>(data + srSize);
 	auto chunk = sdes->getChunk(0);
 	chunk->setSSRC(rtpConfig->ssrc);
 	auto item = chunk->getItem(0);
@@ -86,8 +96,6 @@ message_ptr RtcpSrReporter::getSenderReport(uint32_t timestamp) {
 	sdes->preparePacket(1);
 
 	_previousReportedTimestamp = timestamp;
-
-	return msg;
 }
 
 } // namespace rtc
@@ -0,0 +1,52 @@
+/**
+ * Copyright (c) 2021 Paul-Louis Ageneau
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#if RTC_ENABLE_MEDIA
+
+#include "rtpbridge.hpp"
+
+#include "impl/internals.hpp"
+#include "impl/rtpbridge.hpp"
+
+namespace rtc {
+
+RtpBridge::RtpBridge(Configuration config)
+    : CheshireCat<impl::RtpBridge>(std::move(config), [this](message_ptr message) {
+	      outgoingCallback(std::move(message));
+      }) {}
+
+RtpBridge::~RtpBridge() { impl()->stop(); }
+
+void RtpBridge::stop() { impl()->stop(); }
+
+uint16_t RtpBridge::port() const { return impl()->port(); }
+
+RtpBridge::Backend RtpBridge::backend() const { return impl()->backend(); }
+
+size_t RtpBridge::receivedCount(Backend backend) const { return impl()->receivedCount(backend); }
+
+message_ptr RtpBridge::incoming(message_ptr ptr) {
+	// Forwarded packets are consumed
+	return impl()->egress(ptr) ? nullptr : ptr;
+}
+
+message_ptr RtpBridge::outgoing(message_ptr ptr) { return ptr; }
+
+} // namespace rtc
+
+#endif // RTC_ENABLE_MEDIA
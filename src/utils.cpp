@@ -0,0 +1,87 @@
+/**
+ * Copyright (c) 2021 Paul-Louis Ageneau
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "common.hpp"
+
+#include <atomic>
+#include <thread>
+
+namespace rtc {
+
+namespace {
+
+// Records are never freed, so they can be scanned without locking
+struct thread_record {
+	callback_thread_state state;
+	std::atomic<bool> used = true;
+	thread_record *next = nullptr;
+};
+
+std::atomic<thread_record *> records = nullptr;
+
+thread_record *acquire_record() {
+	// Reuse the record of an exited thread if possible
+	for (auto record = records.load(); record; record = record->next) {
+		bool expected = false;
+		if (record->used.compare_exchange_strong(expected, true))
+			return record;
+	}
+
+	auto record = new thread_record;
+	record->next = records.load();
+	while (!records.compare_exchange_weak(record->next, record))
+		;
+
+	return record;
+}
+
+thread_local thread_record *current_record = nullptr;
+
+struct thread_record_releaser {
+	~thread_record_releaser() {
+		if (current_record) {
+			current_record->used = false;
+			current_record = nullptr;
+		}
+	}
+};
+
+thread_local thread_record_releaser releaser;
+
+} // namespace
+
+callback_thread_state &thread_callback_state() {
+	// Defined here so every module shares the same thread-local state
+	if (!current_record) {
+		current_record = acquire_record();
+		(void)&releaser; // release the record on thread exit
+	}
+	return current_record->state;
+}
+
+void wait_callback_hazards(const void *func) {
+	if (!func)
+		return;
+
+	for (auto record = records.load(); record; record = record->next)
+		for (const auto &hazard : record->state.hazards)
+			while (hazard.load() == func)
+				std::this_thread::yield();
+}
+
+} // namespace rtc
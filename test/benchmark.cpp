@@ -16,13 +16,25 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
  */
 
+#include "benchmark.hpp"
+
 #include "rtc/rtc.hpp"
 
+#include <algorithm>
 #include <atomic>
 #include <chrono>
+#include <ctime>
+#include <fstream>
 #include <iostream>
 #include <memory>
+#include <string>
 #include <thread>
+#include <utility>
+#include <vector>
+
+#ifdef __linux__
+#include <unistd.h>
+#endif
 
 using namespace rtc;
 using namespace std;
@@ -32,19 +44,43 @@ using chrono::duration_cast;
 using chrono::milliseconds;
 using chrono::steady_clock;
 
-template <class T> weak_ptr<T> make_weak_ptr(shared_ptr<T> ptr) { return ptr; }
+pair<shared_ptr<PeerConnection>, shared_ptr<PeerConnection>>
+connectPair(const Configuration &config1, const Configuration &config2) {
+	auto pc1 = make_shared<PeerConnection>(config1);
+	auto pc2 = make_shared<PeerConnection>(config2);
+
+	// Capture weakly, as the callbacks are owned by the Peer Connections
+	pc1->onLocalDescription([weak2 = make_weak_ptr(pc2)](Description sdp) {
+		if (auto pc2 = weak2.lock())
+			pc2->setRemoteDescription(std::move(sdp));
+	});
+	pc1->onLocalCandidate([weak2 = make_weak_ptr(pc2)](Candidate candidate) {
+		if (auto pc2 = weak2.lock())
+			pc2->addRemoteCandidate(std::move(candidate));
+	});
+	pc2->onLocalDescription([weak1 = make_weak_ptr(pc1)](Description sdp) {
+		if (auto pc1 = weak1.lock())
+			pc1->setRemoteDescription(std::move(sdp));
+	});
+	pc2->onLocalCandidate([weak1 = make_weak_ptr(pc1)](Candidate candidate) {
+		if (auto pc1 = weak1.lock())
+			pc1->addRemoteCandidate(std::move(candidate));
+	});
+
+	return {std::move(pc1), std::move(pc2)};
+}
 
-size_t benchmark(milliseconds duration) {
+size_t benchmark(milliseconds duration, const Configuration &config) {
 	rtc::InitLogger(LogLevel::Warning);
 	rtc::Preload();
 
-	Configuration config1;
+	Configuration config1 = config;
 	// config1.iceServers.emplace_back("stun:stun.l.google.com:19302");
 	// config1.mtu = 1500;
 
 	PeerConnection pc1(config1);
 
-	Configuration config2;
+	Configuration config2 = config;
 	// config2.iceServers.emplace_back("stun:stun.l.google.com:19302");
 	// config2.mtu = 1500;
 
@@ -105,6 +141,7 @@ size_t benchmark(milliseconds duration) {
 	});
 
 	startTime = steady_clock::now();
+	const std::clock_t startClock = std::clock();
 	auto dc1 = pc1.createDataChannel("benchmark");
 
 	dc1->onOpen([wdc1 = make_weak_ptr(dc1), &messageData, &openTime]() {
@@ -164,6 +201,12 @@ size_t benchmark(milliseconds duration) {
 	cout << "Goodput: " << goodput * 0.001 << " MB/s"
 	     << " (" << goodput * 0.001 * 8 << " Mbit/s)" << endl;
 
+	// Compare efficiency between execution models
+	double cpuTime = double(std::clock() - startClock) / CLOCKS_PER_SEC;
+	if (cpuTime > 0)
+		cout << "CPU time: " << cpuTime << " s, received per CPU second: "
+		     << received / cpuTime * 1e-6 << " MB" << endl;
+
 	pc1.close();
 	pc2.close();
 
@@ -172,10 +215,171 @@ size_t benchmark(milliseconds duration) {
 	return goodput;
 }
 
+size_t benchmark(milliseconds duration) { return benchmark(duration, Configuration()); }
+
+size_t benchmark_callback(milliseconds duration, int threadsCount) {
+	synchronized_callback<int> callback;
+	atomic<size_t> sum = 0;
+	callback = [&sum](int i) { sum.fetch_add(size_t(i), memory_order_relaxed); };
+
+	atomic<bool> running = true;
+	vector<thread> threads;
+	for (int t = 0; t < threadsCount; ++t)
+		threads.emplace_back([&callback, &running]() {
+			while (running.load(memory_order_relaxed))
+				callback(1);
+		});
+
+	// Replace the callback periodically as the library does when users set handlers
+	size_t replacements = 0;
+	const auto endTime = steady_clock::now() + duration;
+	while (steady_clock::now() < endTime) {
+		this_thread::sleep_for(1ms);
+		callback = [&sum](int i) { sum.fetch_add(size_t(i), memory_order_relaxed); };
+		++replacements;
+	}
+
+	running = false;
+	for (auto &t : threads)
+		t.join();
+
+	size_t rate = duration.count() > 0 ? sum.load() / size_t(duration.count()) : 0;
+	cout << "Callback threads: " << threadsCount << ", replacements: " << replacements << endl;
+	cout << "Callback invocation rate: " << rate * 0.001 << " M/s" << endl;
+	return rate;
+}
+
+size_t resident_memory() {
+#ifdef __linux__
+	std::ifstream statm("/proc/self/statm");
+	size_t size = 0, resident = 0;
+	statm >> size >> resident;
+	return resident * size_t(sysconf(_SC_PAGESIZE));
+#else
+	return 0;
+#endif
+}
+
 #ifdef BENCHMARK_MAIN
 int main(int argc, char **argv) {
 	try {
-		size_t goodput = benchmark(30s);
+		if (argc > 1 && string(argv[1]) == "callback") {
+			const int threadsCount = argc > 2 ? stoi(argv[2]) : 4;
+			if (benchmark_callback(10s, threadsCount) == 0)
+				throw runtime_error("No callback invoked");
+
+			return 0;
+		}
+
+		// Compare with authentication-only SRTP with "medianull", and with the in-process transport
+		// instead of loopback UDP with "mediainprocess"
+		if (argc > 1 && (string(argv[1]) == "media" || string(argv[1]) == "medianull" ||
+		                 string(argv[1]) == "mediainprocess")) {
+			const int ssrcsCount = argc > 2 ? stoi(argv[2]) : 100;
+			Configuration config;
+			config.enableSrtpNullCipher = string(argv[1]) == "medianull";
+			config.enableInProcessTransport = string(argv[1]) == "mediainprocess";
+			if (benchmark_media(10s, ssrcsCount, config) == 0)
+				throw runtime_error("No media received");
+
+			return 0;
+		}
+
+		// Compare with "media", which sends packets with Track::send()
+		// "bridgeuring" receives with io_uring instead of recvmmsg on Linux
+		if (argc > 1 && (string(argv[1]) == "bridge" || string(argv[1]) == "bridgeuring")) {
+			const int burstSize = argc > 2 ? stoi(argv[2]) : 100;
+			RtpBridge::Configuration bridgeConfig;
+			bridgeConfig.enableIoUring = string(argv[1]) == "bridgeuring";
+			if (benchmark_bridge(10s, burstSize, bridgeConfig) == 0)
+				throw runtime_error("No RTP received through the bridge");
+
+			return 0;
+		}
+
+		// Requires root and a veth pair, generic XDP works with any interface:
+		//   ip link add xdp0 type veth peer name xdp1
+		//   ip addr add 10.11.0.2/24 dev xdp0 && ip link set xdp0 up && ip link set xdp1 up
+		// "bridgexdp xdp0 xdp1" receives with AF_XDP, "bridgeveth xdp0 xdp1" with the socket
+		if (argc > 3 && (string(argv[1]) == "bridgeveth" || string(argv[1]) == "bridgexdp")) {
+			const int burstSize = argc > 4 ? stoi(argv[4]) : 100;
+			RtpBridge::Configuration bridgeConfig;
+			bridgeConfig.bindAddress = "0.0.0.0";
+			if (string(argv[1]) == "bridgexdp")
+				bridgeConfig.xdpInterface = argv[2];
+
+			if (benchmark_bridge(10s, burstSize, bridgeConfig, make_pair(argv[2], argv[3])) == 0)
+				throw runtime_error("No RTP received through the bridge");
+
+			return 0;
+		}
+
+		if (argc > 1 && string(argv[1]) == "priority") {
+			const int burstSize = argc > 2 ? stoi(argv[2]) : 100;
+			if (benchmark_priority(10s, burstSize) == 0)
+				throw runtime_error("No audio received");
+
+			return 0;
+		}
+
+		if (argc > 1 && string(argv[1]) == "close") {
+			const int connectionsCount = argc > 2 ? stoi(argv[2]) : 5000;
+			benchmark_close(connectionsCount);
+			return 0;
+		}
+
+		if (argc > 1 && string(argv[1]) == "small") {
+			const size_t messageSize = argc > 2 ? size_t(stoul(argv[2])) : 20;
+			if (benchmark_small(10s, messageSize) == 0)
+				throw runtime_error("No message received");
+
+			return 0;
+		}
+
+		if (argc > 1 && string(argv[1]) == "channels") {
+			const int channelsCount = argc > 2 ? stoi(argv[2]) : 10000;
+			benchmark_channels(channelsCount);
+			return 0;
+		}
+
+		// Compare with callbacks of distinct channels run in parallel with "parallelhandlers"
+		if (argc > 1 && (string(argv[1]) == "handlers" || string(argv[1]) == "parallelhandlers")) {
+			const int channelsCount = argc > 2 ? stoi(argv[2]) : 8;
+			Configuration config;
+			config.enableParallelDataChannels = string(argv[1]) == "parallelhandlers";
+			if (benchmark_handlers(10s, channelsCount, config) == 0)
+				throw runtime_error("No message handled");
+
+			return 0;
+		}
+
+		// Compare with receiving through PeerConnection::poll() with "busylatency"
+		if (argc > 1 && (string(argv[1]) == "latency" || string(argv[1]) == "busylatency")) {
+			Configuration config;
+			config.enableBusyPolling = string(argv[1]) == "busylatency";
+			if (benchmark_latency(10s, config) == 0)
+				throw runtime_error("No message received");
+
+			return 0;
+		}
+
+		// Compare with CRC32c on every SCTP packet
+		if (argc > 1 && string(argv[1]) == "nozerochecksum") {
+			SctpSettings settings;
+			settings.zeroChecksum = false;
+			rtc::SetSctpSettings(std::move(settings));
+		}
+
+		// Compare with connections pinned to loop threads
+		Configuration config;
+		if (argc > 1 && string(argv[1]) == "loop")
+			config.pinToLoopThread = true;
+
+		// Compare with the in-process transport instead of loopback UDP
+		if (argc > 1 && string(argv[1]) == "inprocess")
+			config.enableInProcessTransport = true;
+
+		size_t goodput = benchmark(30s, config);
 		if (goodput == 0)
 			throw runtime_error("No data received");
 
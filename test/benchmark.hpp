@@ -0,0 +1,59 @@
+/**
+ * Copyright (c) 2019 Paul-Louis Ageneau
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef RTC_TEST_BENCHMARK_H
+#define RTC_TEST_BENCHMARK_H
+
+#include "rtc/rtc.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+
+template <class T> std::weak_ptr<T> make_weak_ptr(std::shared_ptr<T> ptr) { return ptr; }
+
+// Create two Peer Connections which signal each other directly
+std::pair<std::shared_ptr<rtc::PeerConnection>, std::shared_ptr<rtc::PeerConnection>>
+connectPair(const rtc::Configuration &config1 = {}, const rtc::Configuration &config2 = {});
+
+size_t resident_memory(); // bytes, 0 if unknown
+
+// Media, see benchmark_media.cpp
+size_t benchmark_media(std::chrono::milliseconds duration, int ssrcsCount,
+                       const rtc::Configuration &config);
+size_t benchmark_priority(std::chrono::milliseconds duration, int burstSize);
+
+// Connections, see benchmark_connection.cpp
+size_t benchmark_close(int connectionsCount);
+
+// DataChannels, see benchmark_datachannel.cpp
+size_t benchmark_small(std::chrono::milliseconds duration, size_t messageSize);
+size_t benchmark_channels(int channelsCount);
+size_t benchmark_handlers(std::chrono::milliseconds duration, int channelsCount,
+                          const rtc::Configuration &config);
+size_t benchmark_latency(std::chrono::milliseconds duration, const rtc::Configuration &config);
+
+// RTP bridge, see benchmark_bridge.cpp
+size_t benchmark_bridge(std::chrono::milliseconds duration, int burstSize,
+                        rtc::RtpBridge::Configuration bridgeConfig,
+                        std::optional<std::pair<std::string, std::string>> veth = std::nullopt);
+
+#endif
@@ -0,0 +1,290 @@
+/**
+ * Copyright (c) 2019 Paul-Louis Ageneau
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "benchmark.hpp"
+
+#include "rtc/rtc.hpp"
+#include "rtc/rtp.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <utility>
+
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+#include <ifaddrs.h>
+#include <linux/if_packet.h>
+#include <net/if.h>
+#include <sys/ioctl.h>
+#endif
+
+using namespace rtc;
+using namespace std;
+using namespace chrono_literals;
+
+using chrono::duration_cast;
+using chrono::milliseconds;
+using chrono::steady_clock;
+
+#ifdef __linux__
+// Sends UDP datagrams as raw Ethernet frames on the sender interface of a veth pair, so they are
+// received on the ingress interface like packets from the network. Requires CAP_NET_RAW.
+class VethSender {
+public:
+	VethSender(const string &ingressInterface, const string &senderInterface, uint16_t port) {
+		mSock = ::socket(AF_PACKET, SOCK_RAW, 0);
+		if (mSock < 0)
+			throw runtime_error("Packet socket creation failed");
+
+		mAddr.sll_family = AF_PACKET;
+		mAddr.sll_ifindex = int(if_nametoindex(senderInterface.c_str()));
+		mAddr.sll_halen = 6;
+		if (mAddr.sll_ifindex == 0)
+			throw runtime_error("Unknown interface: " + senderInterface);
+
+		// Ethernet
+		mFrame.resize(14 + 20 + 8);
+		hardwareAddress(ingressInterface, mFrame.data());
+		hardwareAddress(senderInterface, mFrame.data() + 6);
+		std::memcpy(mAddr.sll_addr, mFrame.data(), 6);
+		mFrame[12] = byte(0x08);
+
+		// IPv4, from another address on the subnet so reverse path filtering accepts it
+		in_addr_t dst = ingressAddress(ingressInterface);
+		in_addr_t src = dst ^ htonl(1);
+		byte *ip = mFrame.data() + 14;
+		ip[0] = byte(0x45);
+		ip[6] = byte(0x40); // don't fragment
+		ip[8] = byte(64);
+		ip[9] = byte(IPPROTO_UDP);
+		std::memcpy(ip + 12, &src, 4);
+		std::memcpy(ip + 16, &dst, 4);
+
+		// UDP, the checksum is optional over IPv4
+		byte *udp = ip + 20;
+		udp[2] = byte(port >> 8);
+		udp[3] = byte(port & 0xFF);
+	}
+
+	~VethSender() { ::close(mSock); }
+
+	bool send(const binary &payload) {
+		uint16_t udpLen = uint16_t(8 + payload.size());
+		uint16_t ipLen = uint16_t(20 + udpLen);
+		byte *ip = mFrame.data() + 14;
+		ip[2] = byte(ipLen >> 8);
+		ip[3] = byte(ipLen & 0xFF);
+		ip[10] = ip[11] = byte(0);
+		uint16_t checksum = ipChecksum(ip);
+		ip[10] = byte(checksum >> 8);
+		ip[11] = byte(checksum & 0xFF);
+		byte *udp = ip + 20;
+		udp[4] = byte(udpLen >> 8);
+		udp[5] = byte(udpLen & 0xFF);
+
+		mFrame.resize(14 + 20 + 8);
+		mFrame.insert(mFrame.end(), payload.begin(), payload.end());
+		return ::sendto(mSock, mFrame.data(), mFrame.size(), 0,
+		                reinterpret_cast<const sockaddr *>(&mAddr), sizeof(mAddr)) > 0;
+	}
+
+private:
+	static void hardwareAddress(const string &interfaceName, byte *out) {
+		ifreq req = {};
+		std::strncpy(req.ifr_name, interfaceName.c_str(), IFNAMSIZ - 1);
+		int sock = ::socket(AF_INET, SOCK_DGRAM, 0);
+		int ret = ::ioctl(sock, SIOCGIFHWADDR, &req);
+		::close(sock);
+		if (ret < 0)
+			throw runtime_error("Failed to get hardware address of " + interfaceName);
+
+		std::memcpy(out, req.ifr_hwaddr.sa_data, 6);
+	}
+
+	static in_addr_t ingressAddress(const string &interfaceName) {
+		ifaddrs *ifas = nullptr;
+		if (::getifaddrs(&ifas) < 0)
+			throw runtime_error("getifaddrs failed");
+
+		optional<in_addr_t> result;
+		for (auto ifa = ifas; ifa && !result; ifa = ifa->ifa_next)
+			if (ifa->ifa_addr && ifa->ifa_addr->sa_family == AF_INET &&
+			    interfaceName == ifa->ifa_name)
+				result = reinterpret_cast<sockaddr_in *>(ifa->ifa_addr)->sin_addr.s_addr;
+
+		::freeifaddrs(ifas);
+		if (!result)
+			throw runtime_error("No IPv4 address on " + interfaceName);
+
+		return *result;
+	}
+
+	static uint16_t ipChecksum(const byte *header) {
+		uint32_t sum = 0;
+		for (int i = 0; i < 20; i += 2)
+			sum += uint32_t(to_integer<uint8_t>(header[i])) << 8 |
+			       to_integer<uint8_t>(header[i + 1]);
+		while (sum >> 16)
+			sum = (sum & 0xFFFF) + (sum >> 16);
+		return uint16_t(~sum);
+	}
+
+	int mSock;
+	sockaddr_ll mAddr = {};
+	binary mFrame;
+};
+#endif
+
+size_t benchmark_bridge(milliseconds duration, int burstSize, RtpBridge::Configuration bridgeConfig,
+                        optional<pair<string, string>> veth) {
+#ifndef _WIN32
+	rtc::InitLogger(LogLevel::Warning);
+	rtc::Preload();
+
+	shared_ptr<PeerConnection> pc1, pc2;
+	std::tie(pc1, pc2) = connectPair();
+
+	// The bridge rewrites SSRC and payload type, count received packets which have them
+	const uint32_t ssrc = 42;
+	const uint8_t payloadType = 96;
+	atomic<size_t> receivedCount = 0, rewrittenCount = 0;
+	shared_ptr<Track> t2;
+	pc2->onTrack([&](shared_ptr<Track> t) {
+		t->onMessage([&](message_variant message) {
+			if (!holds_alternative<binary>(message))
+				return;
+
+			auto &packet = get<binary>(message);
+			auto rtp = reinterpret_cast<const RTP *>(packet.data());
+			if (rtp->ssrc() == ssrc && rtp->payloadType() == payloadType)
+				++rewrittenCount;
+
+			++receivedCount;
+		});
+		std::atomic_store(&t2, t);
+	});
+
+	Description::Video media("video", Description::Direction::SendOnly);
+	media.addH264Codec(payloadType);
+	media.addSSRC(ssrc, "video-send");
+
+	auto t1 = pc1->addTrack(media);
+
+	bridgeConfig.ssrc = ssrc;
+	bridgeConfig.payloadType = payloadType;
+	auto bridge = std::make_shared<RtpBridge>(bridgeConfig);
+	t1->setMediaHandler(bridge);
+
+	pc1->setLocalDescription();
+
+	const auto openEndTime = steady_clock::now() + 10s;
+	while (!t1->isOpen() && steady_clock::now() < openEndTime)
+		this_thread::sleep_for(100ms);
+
+	if (!t1->isOpen())
+		throw runtime_error("Track is not open");
+
+	// Send RTP over loopback UDP like a local GStreamer or ffmpeg pipeline would, or from the
+	// network through a veth pair
+	int sock = ::socket(AF_INET, SOCK_DGRAM, 0);
+	if (sock < 0)
+		throw runtime_error("UDP socket creation failed");
+
+	sockaddr_in addr = {};
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	addr.sin_port = htons(bridge->port());
+
+	std::function<bool(const binary &)> send = [&](const binary &packet) {
+		return ::sendto(sock, packet.data(), packet.size(), 0,
+		                reinterpret_cast<const sockaddr *>(&addr), sizeof(addr)) > 0;
+	};
+
+#ifdef __linux__
+	unique_ptr<VethSender> vethSender;
+	if (veth) {
+		vethSender = std::make_unique<VethSender>(veth->first, veth->second, bridge->port());
+		send = [&](const binary &packet) { return vethSender->send(packet); };
+	}
+#else
+	if (veth)
+		throw runtime_error("Sending through a veth pair requires Linux");
+#endif
+
+	const size_t packetSize = 1200;
+	binary packet(packetSize, byte(0));
+	auto rtp = reinterpret_cast<RTP *>(packet.data());
+	rtp->preparePacket();
+	rtp->setPayloadType(100);
+	rtp->setSsrc(1234);
+
+	uint16_t seqNumber = 0;
+	size_t sentCount = 0;
+	const std::clock_t startClock = std::clock();
+	const auto startTime = steady_clock::now();
+	const auto endTime = startTime + duration;
+	while (steady_clock::now() < endTime) {
+		for (int i = 0; i < burstSize; ++i) {
+			rtp->setSeqNumber(seqNumber++);
+			rtp->setTimestamp(uint32_t(sentCount));
+			if (send(packet))
+				++sentCount;
+		}
+		// Pace to avoid filling the UDP buffers
+		this_thread::sleep_for(1ms);
+	}
+
+	this_thread::sleep_for(1s);
+	::close(sock);
+
+	// CPU time of the whole process, the sender is identical whatever the receive path
+	double cpuSeconds = double(std::clock() - startClock) / CLOCKS_PER_SEC;
+
+	size_t received = receivedCount.load();
+	size_t rate = duration.count() > 0 ? received * 1000 / size_t(duration.count()) : 0;
+	cout << "Sent: " << sentCount << ", received: " << received
+	     << ", rewritten: " << rewrittenCount.load() << endl;
+	cout << "Packet rate: " << rate << " packets/s" << endl;
+	if (cpuSeconds > 0)
+		cout << "Packets per CPU second: " << size_t(received / cpuSeconds) << endl;
+
+	bridge->stop();
+	pc1->close();
+	pc2->close();
+
+	rtc::Cleanup();
+	this_thread::sleep_for(1s);
+	return rewrittenCount == received ? rate : 0;
+#else
+	return 0;
+#endif
+}
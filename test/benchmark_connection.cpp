@@ -0,0 +1,119 @@
+/**
+ * Copyright (c) 2019 Paul-Louis Ageneau
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "benchmark.hpp"
+
+#include "rtc/rtc.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+using namespace rtc;
+using namespace std;
+using namespace chrono_literals;
+
+using chrono::duration_cast;
+using chrono::milliseconds;
+using chrono::steady_clock;
+
+size_t benchmark_close(int connectionsCount) {
+	rtc::InitLogger(LogLevel::Warning);
+	rtc::Preload();
+
+	// A live connection measures how traffic is delayed while other connections are torn down
+	shared_ptr<PeerConnection> pc1, pc2;
+	std::tie(pc1, pc2) = connectPair();
+
+	shared_ptr<DataChannel> dc2;
+	pc2->onDataChannel([&dc2](shared_ptr<DataChannel> dc) {
+		// Echo back
+		dc->onMessage([wdc = make_weak_ptr(dc)](variant<binary, string> message) {
+			if (auto dc = wdc.lock())
+				dc->send(std::move(message));
+		});
+		std::atomic_store(&dc2, dc);
+	});
+
+	atomic<steady_clock::rep> maxRtt = 0;
+	atomic<bool> pending = false;
+	atomic<steady_clock::rep> pingTime = 0;
+	auto dc1 = pc1->createDataChannel("ping");
+	dc1->onMessage([&maxRtt, &pending, &pingTime](variant<binary, string>) {
+		auto rtt = steady_clock::now().time_since_epoch().count() - pingTime;
+		if (rtt > maxRtt)
+			maxRtt = rtt;
+		pending = false;
+	});
+
+	const auto openEndTime = steady_clock::now() + 10s;
+	while (!dc1->isOpen() && steady_clock::now() < openEndTime)
+		this_thread::sleep_for(100ms);
+
+	if (!dc1->isOpen())
+		throw runtime_error("DataChannel is not open");
+
+	cout << "Creating " << connectionsCount << " connections..." << endl;
+	vector<shared_ptr<PeerConnection>> peerConnections;
+	peerConnections.reserve(connectionsCount);
+	for (int i = 0; i < connectionsCount; ++i) {
+		auto pc = make_shared<PeerConnection>();
+		pc->createDataChannel("test"); // start ICE gathering
+		peerConnections.push_back(std::move(pc));
+	}
+
+	this_thread::sleep_for(1s);
+
+	cout << "Closing " << connectionsCount << " connections..." << endl;
+	atomic<bool> closing = true;
+	thread pinger([&]() {
+		while (closing) {
+			if (!pending.exchange(true)) {
+				pingTime = steady_clock::now().time_since_epoch().count();
+				dc1->send("ping");
+			}
+			this_thread::sleep_for(1ms);
+		}
+	});
+
+	const auto startTime = steady_clock::now();
+	for (auto &pc : peerConnections)
+		pc->close();
+
+	peerConnections.clear();
+	const auto closeDuration = duration_cast<milliseconds>(steady_clock::now() - startTime);
+
+	this_thread::sleep_for(5s);
+	closing = false;
+	pinger.join();
+
+	auto rtt = duration_cast<milliseconds>(steady_clock::duration(maxRtt.load()));
+	cout << "Close duration: " << closeDuration.count() << " ms" << endl;
+	cout << "Max round-trip time during teardown: " << rtt.count() << " ms" << endl;
+
+	pc1->close();
+	pc2->close();
+
+	rtc::Cleanup();
+	this_thread::sleep_for(1s);
+	return size_t(closeDuration.count());
+}
@@ -0,0 +1,349 @@
+/**
+ * Copyright (c) 2019 Paul-Louis Ageneau
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "benchmark.hpp"
+
+#include "rtc/rtc.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+using namespace rtc;
+using namespace std;
+using namespace chrono_literals;
+
+using chrono::duration_cast;
+using chrono::milliseconds;
+using chrono::steady_clock;
+
+size_t benchmark_small(milliseconds duration, size_t messageSize) {
+	rtc::InitLogger(LogLevel::Warning);
+	rtc::Preload();
+
+	shared_ptr<PeerConnection> pc1, pc2;
+	std::tie(pc1, pc2) = connectPair();
+
+	atomic<size_t> receivedCount = 0;
+	shared_ptr<DataChannel> dc2;
+	pc2->onDataChannel([&dc2, &receivedCount](shared_ptr<DataChannel> dc) {
+		dc->onMessage([&receivedCount](variant<binary, string> message) {
+			if (holds_alternative<binary>(message))
+				++receivedCount;
+		});
+		std::atomic_store(&dc2, dc);
+	});
+
+	auto dc1 = pc1->createDataChannel("small");
+
+	const auto openEndTime = steady_clock::now() + 10s;
+	while (!dc1->isOpen() && steady_clock::now() < openEndTime)
+		this_thread::sleep_for(100ms);
+
+	if (!dc1->isOpen())
+		throw runtime_error("DataChannel is not open");
+
+	const binary messageData(messageSize, byte(0xFF));
+
+	// Queue messages faster than they can be sent to measure the memory used by buffered ones
+	const size_t queuedCount = 100000;
+	const size_t memoryBefore = resident_memory();
+	for (size_t i = 0; i < queuedCount; ++i)
+		dc1->send(messageData);
+
+	const size_t buffered = dc1->bufferedAmount() / messageSize;
+	const size_t memoryAfter = resident_memory();
+	if (buffered > 0 && memoryAfter > memoryBefore)
+		cout << "Memory per buffered message: " << (memoryAfter - memoryBefore) / buffered
+		     << " bytes (" << buffered << " buffered)" << endl;
+
+	while (dc1->bufferedAmount() > 0)
+		this_thread::sleep_for(10ms);
+
+	// Keep the buffered amount low to measure the message rate
+	const size_t startCount = receivedCount.load();
+	dc1->setBufferedAmountLowThreshold(1000 * messageSize);
+	auto sendMore = [wdc1 = make_weak_ptr(dc1), &messageData]() {
+		auto dc1 = wdc1.lock();
+		if (!dc1)
+			return;
+
+		try {
+			while (dc1->isOpen() && dc1->bufferedAmount() < 10000 * messageData.size())
+				dc1->send(messageData);
+		} catch (const std::exception &e) {
+			std::cout << "Send failed: " << e.what() << std::endl;
+		}
+	};
+	dc1->onBufferedAmountLow(sendMore);
+	sendMore();
+
+	this_thread::sleep_for(duration);
+
+	dc1->close();
+
+	size_t received = receivedCount.load() - startCount;
+	size_t rate = duration.count() > 0 ? received * 1000 / size_t(duration.count()) : 0;
+	cout << "Message size: " << messageSize << " bytes" << endl;
+	cout << "Message rate: " << rate << " messages/s" << endl;
+
+	pc1->close();
+	pc2->close();
+
+	rtc::Cleanup();
+	this_thread::sleep_for(1s);
+	return rate;
+}
+
+size_t benchmark_channels(int channelsCount) {
+	rtc::InitLogger(LogLevel::Warning);
+	rtc::Preload();
+
+	shared_ptr<PeerConnection> pc1, pc2;
+	std::tie(pc1, pc2) = connectPair();
+
+	vector<string> labels;
+	labels.reserve(channelsCount);
+	for (int i = 0; i < channelsCount; ++i)
+		labels.push_back("channel-" + to_string(i));
+
+	// Negotiated channels with the same ids on both sides, opening needs no handshake
+	DataChannelInit init;
+	init.negotiated = true;
+	init.id = 0;
+
+	atomic<int> openCount = 0;
+	const auto startTime = steady_clock::now();
+	auto channels2 = pc2->createDataChannels(labels, init);
+	auto channels1 = pc1->createDataChannels(labels, init);
+	const auto createdTime = steady_clock::now();
+
+	for (auto &dc : channels1)
+		dc->onOpen([&openCount]() { ++openCount; });
+
+	const auto openEndTime = steady_clock::now() + 30s;
+	while (openCount < channelsCount && steady_clock::now() < openEndTime)
+		this_thread::sleep_for(10ms);
+
+	const auto openTime = steady_clock::now();
+	if (openCount < channelsCount)
+		throw runtime_error("Only " + to_string(openCount.load()) + " DataChannels open");
+
+	cout << "Create duration for " << channelsCount << " DataChannels: "
+	     << duration_cast<milliseconds>(createdTime - startTime).count() << " ms" << endl;
+	cout << "Connect and open duration: "
+	     << duration_cast<milliseconds>(openTime - createdTime).count() << " ms" << endl;
+
+	pc1->close();
+	pc2->close();
+
+	rtc::Cleanup();
+	this_thread::sleep_for(1s);
+	return size_t(openCount.load());
+}
+
+size_t benchmark_handlers(milliseconds duration, int channelsCount, const Configuration &config) {
+	rtc::InitLogger(LogLevel::Warning);
+	rtc::Preload();
+
+	shared_ptr<PeerConnection> pc1, pc2;
+	std::tie(pc1, pc2) = connectPair(config, config);
+
+	vector<string> labels;
+	labels.reserve(channelsCount);
+	for (int i = 0; i < channelsCount; ++i)
+		labels.push_back("handlers-" + to_string(i));
+
+	DataChannelInit init;
+	init.negotiated = true;
+	init.id = 0;
+
+	auto channels2 = pc2->createDataChannels(labels, init);
+	auto channels1 = pc1->createDataChannels(labels, init);
+
+	// Each message simulates application work, like parsing or a database write
+	atomic<size_t> receivedCount = 0;
+	for (auto &dc : channels2)
+		dc->onMessage([&receivedCount](variant<binary, string> message) {
+			if (holds_alternative<binary>(message)) {
+				this_thread::sleep_for(100us);
+				++receivedCount;
+			}
+		});
+
+	const auto openEndTime = steady_clock::now() + 10s;
+	auto allOpen = [&channels1]() {
+		return std::all_of(channels1.begin(), channels1.end(),
+		                   [](const shared_ptr<DataChannel> &dc) { return dc->isOpen(); });
+	};
+	while (!allOpen() && steady_clock::now() < openEndTime)
+		this_thread::sleep_for(100ms);
+
+	if (!allOpen())
+		throw runtime_error("DataChannels are not open");
+
+	// Keep every channel busy so the receiving side is limited by handlers only
+	const binary messageData(100, byte(0xFF));
+	for (auto &dc1 : channels1) {
+		dc1->setBufferedAmountLowThreshold(100 * messageData.size());
+		auto sendMore = [wdc1 = make_weak_ptr(dc1), &messageData]() {
+			auto dc1 = wdc1.lock();
+			if (!dc1)
+				return;
+
+			try {
+				while (dc1->isOpen() && dc1->bufferedAmount() < 1000 * messageData.size())
+					dc1->send(messageData);
+			} catch (const std::exception &e) {
+				std::cout << "Send failed: " << e.what() << std::endl;
+			}
+		};
+		dc1->onBufferedAmountLow(sendMore);
+		sendMore();
+	}
+
+	const size_t startCount = receivedCount.load();
+	this_thread::sleep_for(duration);
+	const size_t received = receivedCount.load() - startCount;
+
+	for (auto &dc1 : channels1)
+		dc1->close();
+
+	size_t rate = duration.count() > 0 ? received * 1000 / size_t(duration.count()) : 0;
+	cout << "Channels: " << channelsCount
+	     << (config.enableParallelDataChannels ? " (parallel dispatch)" : "") << endl;
+	cout << "Handled message rate: " << rate << " messages/s" << endl;
+
+	pc1->close();
+	pc2->close();
+
+	rtc::Cleanup();
+	this_thread::sleep_for(1s);
+	return rate;
+}
+
+size_t benchmark_latency(milliseconds duration, const Configuration &config) {
+	rtc::InitLogger(LogLevel::Warning);
+	rtc::Preload();
+
+	shared_ptr<PeerConnection> pc1, pc2;
+	std::tie(pc1, pc2) = connectPair(config, config);
+
+	DataChannelInit init;
+	init.negotiated = true;
+	init.id = 0;
+
+	auto dc2 = pc2->createDataChannel("latency", init);
+	auto dc1 = pc1->createDataChannel("latency", init);
+
+	// Messages carry their send time
+	std::mutex latenciesMutex;
+	vector<chrono::microseconds> latencies;
+	auto handle = [&](const message_variant &message) {
+		if (!holds_alternative<binary>(message) || get<binary>(message).size() < sizeof(int64_t))
+			return;
+
+		int64_t sendTime;
+		std::memcpy(&sendTime, get<binary>(message).data(), sizeof(sendTime));
+		auto latency = chrono::duration_cast<chrono::microseconds>(
+		    steady_clock::now().time_since_epoch() - steady_clock::duration(sendTime));
+
+		std::lock_guard lock(latenciesMutex);
+		latencies.push_back(latency);
+	};
+
+	// With busy-polling, both sides must be polled from the start as the association is set up
+	// on receive, and the receiving side drains its channel instead of getting callbacks
+	atomic<bool> polling = config.enableBusyPolling;
+	std::thread poller;
+	if (config.enableBusyPolling) {
+		poller = std::thread([&]() {
+			while (polling) {
+				pc1->poll();
+				pc2->poll();
+				while (auto message = dc2->receive())
+					handle(*message);
+			}
+		});
+	} else {
+		dc2->onMessage([&handle](message_variant message) { handle(message); });
+	}
+
+	const auto openEndTime = steady_clock::now() + 10s;
+	while (!dc1->isOpen() && steady_clock::now() < openEndTime)
+		this_thread::sleep_for(100ms);
+
+	if (!dc1->isOpen()) {
+		polling = false;
+		if (poller.joinable())
+			poller.join();
+
+		throw runtime_error("DataChannel is not open");
+	}
+
+	// Send a small message every millisecond, so latency is not dominated by queuing
+	size_t sentCount = 0;
+	binary messageData(100, byte(0xFF));
+	const auto endTime = steady_clock::now() + duration;
+	while (steady_clock::now() < endTime) {
+		int64_t sendTime = steady_clock::now().time_since_epoch().count();
+		std::memcpy(messageData.data(), &sendTime, sizeof(sendTime));
+		dc1->send(messageData);
+		++sentCount;
+
+		this_thread::sleep_for(1ms);
+	}
+
+	this_thread::sleep_for(1s);
+	polling = false;
+	if (poller.joinable())
+		poller.join();
+
+	size_t received;
+	{
+		std::lock_guard lock(latenciesMutex);
+		received = latencies.size();
+		std::sort(latencies.begin(), latencies.end());
+		auto percentile = [&](double p) {
+			return latencies.empty()
+			           ? 0
+			           : latencies[std::min(latencies.size() - 1, size_t(p * latencies.size()))]
+			                 .count();
+		};
+
+		cout << "Receive mode: " << (config.enableBusyPolling ? "busy-polling" : "callbacks")
+		     << ", sent: " << sentCount << ", received: " << received << endl;
+		cout << "Latency p50: " << percentile(0.50) << " us, p99: " << percentile(0.99)
+		     << " us, max: " << percentile(1.) << " us" << endl;
+	}
+
+	pc1->close();
+	pc2->close();
+
+	rtc::Cleanup();
+	this_thread::sleep_for(1s);
+	return received;
+}
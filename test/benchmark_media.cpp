@@ -0,0 +1,231 @@
+/**
+ * Copyright (c) 2019 Paul-Louis Ageneau
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "benchmark.hpp"
+
+#include "rtc/rtc.hpp"
+#include "rtc/rtp.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+using namespace rtc;
+using namespace std;
+using namespace chrono_literals;
+
+using chrono::duration_cast;
+using chrono::milliseconds;
+using chrono::steady_clock;
+
+size_t benchmark_media(milliseconds duration, int ssrcsCount, const Configuration &config) {
+	rtc::InitLogger(LogLevel::Warning);
+	rtc::Preload();
+
+	shared_ptr<PeerConnection> pc1, pc2;
+	std::tie(pc1, pc2) = connectPair(config, config);
+
+	atomic<size_t> receivedCount = 0;
+	shared_ptr<Track> t2;
+	pc2->onTrack([&t2, &receivedCount](shared_ptr<Track> t) {
+		t->onMessage([&receivedCount](message_variant message) {
+			if (holds_alternative<binary>(message))
+				++receivedCount;
+		});
+		std::atomic_store(&t2, t);
+	});
+
+	const uint32_t firstSsrc = 42;
+	Description::Video media("video", Description::Direction::SendOnly);
+	media.addH264Codec(96);
+	for (int i = 0; i < ssrcsCount; ++i)
+		media.addSSRC(firstSsrc + uint32_t(i), "video-send");
+
+	auto t1 = pc1->addTrack(media);
+	pc1->setLocalDescription();
+
+	const auto openEndTime = steady_clock::now() + 10s;
+	while (!t1->isOpen() && steady_clock::now() < openEndTime)
+		this_thread::sleep_for(100ms);
+
+	if (!t1->isOpen())
+		throw runtime_error("Track is not open");
+
+	// Send small RTP packets round-robin over SSRCs, as an SFU forwarding many streams would
+	const size_t packetSize = 200;
+	vector<uint16_t> seqNumbers(ssrcsCount, 0);
+	size_t sentCount = 0;
+	const auto startTime = steady_clock::now();
+	const auto endTime = startTime + duration;
+	while (steady_clock::now() < endTime) {
+		for (int i = 0; i < ssrcsCount; ++i) {
+			binary packet(packetSize, byte(0));
+			auto rtp = reinterpret_cast<RTP *>(packet.data());
+			rtp->preparePacket();
+			rtp->setPayloadType(96);
+			rtp->setSsrc(firstSsrc + uint32_t(i));
+			rtp->setSeqNumber(seqNumbers[i]++);
+			rtp->setTimestamp(uint32_t(sentCount));
+			t1->send(std::move(packet));
+			++sentCount;
+		}
+		// Pace to avoid filling the UDP buffers
+		this_thread::sleep_for(1ms);
+	}
+
+	this_thread::sleep_for(1s);
+
+	size_t received = receivedCount.load();
+	size_t rate = duration.count() > 0 ? received * 1000 / size_t(duration.count()) : 0;
+	cout << "SSRCs: " << ssrcsCount << ", sent: " << sentCount << ", received: " << received
+	     << endl;
+	cout << "Packet rate: " << rate << " packets/s" << endl;
+
+	pc1->close();
+	pc2->close();
+
+	rtc::Cleanup();
+	this_thread::sleep_for(1s);
+	return rate;
+}
+
+size_t benchmark_priority(milliseconds duration, int burstSize) {
+	rtc::InitLogger(LogLevel::Warning);
+	rtc::Preload();
+
+	shared_ptr<PeerConnection> pc1, pc2;
+	std::tie(pc1, pc2) = connectPair();
+
+	// Audio packets carry their send time after the RTP header
+	const size_t rtpHeaderSize = 12;
+	std::mutex latenciesMutex;
+	vector<chrono::microseconds> latencies;
+	vector<shared_ptr<Track>> remoteTracks;
+	pc2->onTrack([&](shared_ptr<Track> t) {
+		if (t->description().type() == "audio") {
+			t->onMessage([&](message_variant message) {
+				if (!holds_alternative<binary>(message))
+					return;
+
+				const auto &packet = get<binary>(message);
+				if (packet.size() < rtpHeaderSize + sizeof(int64_t))
+					return;
+
+				int64_t sendTime;
+				std::memcpy(&sendTime, packet.data() + rtpHeaderSize, sizeof(sendTime));
+				auto latency = chrono::duration_cast<chrono::microseconds>(
+				    steady_clock::now().time_since_epoch() - steady_clock::duration(sendTime));
+
+				std::lock_guard lock(latenciesMutex);
+				latencies.push_back(latency);
+			});
+		}
+		std::lock_guard lock(latenciesMutex);
+		remoteTracks.push_back(t);
+	});
+
+	Description::Audio audio("audio", Description::Direction::SendOnly);
+	audio.addOpusCodec(111);
+	audio.addSSRC(1, "audio-send");
+	auto audioTrack = pc1->addTrack(audio);
+
+	Description::Video video("video", Description::Direction::SendOnly);
+	video.addH264Codec(96);
+	video.addSSRC(2, "video-send");
+	auto videoTrack = pc1->addTrack(video);
+
+	pc1->setLocalDescription();
+
+	const auto openEndTime = steady_clock::now() + 10s;
+	while ((!audioTrack->isOpen() || !videoTrack->isOpen()) && steady_clock::now() < openEndTime)
+		this_thread::sleep_for(100ms);
+
+	if (!audioTrack->isOpen() || !videoTrack->isOpen())
+		throw runtime_error("Tracks are not open");
+
+	auto makePacket = [](size_t size, uint8_t payloadType, uint32_t ssrc, uint16_t seqNumber) {
+		binary packet(size, byte(0));
+		auto rtp = reinterpret_cast<RTP *>(packet.data());
+		rtp->preparePacket();
+		rtp->setPayloadType(payloadType);
+		rtp->setSsrc(ssrc);
+		rtp->setSeqNumber(seqNumber);
+		return packet;
+	};
+
+	const auto endTime = steady_clock::now() + duration;
+
+	// Video sends keyframe-like bursts at 30 fps from its own thread
+	std::thread videoThread([&]() {
+		uint16_t seqNumber = 0;
+		while (steady_clock::now() < endTime) {
+			for (int i = 0; i < burstSize; ++i)
+				videoTrack->send(makePacket(1200, 96, 2, seqNumber++));
+
+			this_thread::sleep_for(33ms);
+		}
+	});
+
+	// Audio sends a packet every 20 ms
+	size_t sentCount = 0;
+	uint16_t seqNumber = 0;
+	while (steady_clock::now() < endTime) {
+		auto packet = makePacket(160, 111, 1, seqNumber++);
+		int64_t sendTime = steady_clock::now().time_since_epoch().count();
+		std::memcpy(packet.data() + rtpHeaderSize, &sendTime, sizeof(sendTime));
+		audioTrack->send(std::move(packet));
+		++sentCount;
+
+		this_thread::sleep_for(20ms);
+	}
+
+	videoThread.join();
+	this_thread::sleep_for(1s);
+
+	size_t received;
+	{
+		std::lock_guard lock(latenciesMutex);
+		received = latencies.size();
+		std::sort(latencies.begin(), latencies.end());
+		auto percentile = [&](double p) {
+			return latencies.empty()
+			           ? 0
+			           : latencies[std::min(latencies.size() - 1, size_t(p * latencies.size()))]
+			                 .count();
+		};
+
+		cout << "Video burst: " << burstSize << " packets, audio sent: " << sentCount
+		     << ", received: " << received << endl;
+		cout << "Audio latency p50: " << percentile(0.50) << " us, p99: " << percentile(0.99)
+		     << " us, max: " << percentile(1.) << " us" << endl;
+	}
+
+	pc1->close();
+	pc2->close();
+
+	rtc::Cleanup();
+	this_thread::sleep_for(1s);
+	return received;
+}
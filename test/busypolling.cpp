@@ -0,0 +1,112 @@
+/**
+ * Copyright (c) 2021 Paul-Louis Ageneau
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "rtc/rtc.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace rtc;
+using namespace std;
+using namespace std::chrono_literals;
+
+void test_busy_polling() {
+	InitLogger(LogLevel::Warning);
+
+	PeerConnection pc1;
+
+	// The receiver gets messages with poll() and receive() instead of callbacks
+	Configuration config2;
+	config2.enableBusyPolling = true;
+	PeerConnection pc2(config2);
+
+	pc1.onLocalDescription([&pc2](Description sdp) { pc2.setRemoteDescription(std::move(sdp)); });
+	pc1.onLocalCandidate(
+	    [&pc2](Candidate candidate) { pc2.addRemoteCandidate(std::move(candidate)); });
+	pc2.onLocalDescription([&pc1](Description sdp) { pc1.setRemoteDescription(std::move(sdp)); });
+	pc2.onLocalCandidate(
+	    [&pc1](Candidate candidate) { pc1.addRemoteCandidate(std::move(candidate)); });
+
+	std::mutex mutex;
+	shared_ptr<DataChannel> dc2;
+	pc2.onDataChannel([&](shared_ptr<DataChannel> dc) {
+		std::lock_guard lock(mutex);
+		dc2 = std::move(dc);
+	});
+
+	auto getDc2 = [&]() {
+		std::lock_guard lock(mutex);
+		return dc2;
+	};
+
+	// pc2 must be polled from the start, as the association is set up on receive
+	auto poll = [&pc2](chrono::milliseconds duration) {
+		const auto endTime = chrono::steady_clock::now() + duration;
+		while (chrono::steady_clock::now() < endTime)
+			if (!pc2.poll())
+				this_thread::sleep_for(1ms);
+	};
+
+	auto dc1 = pc1.createDataChannel("test");
+
+	int attempts = 100;
+	while ((!dc1->isOpen() || !getDc2() || !getDc2()->isOpen()) && attempts--)
+		poll(100ms);
+
+	if (!dc1->isOpen() || !getDc2() || !getDc2()->isOpen())
+		throw runtime_error("DataChannel is not open");
+
+	// Send more reliable messages than the receiving queue holds
+	const int messagesCount = 10000;
+	for (int i = 0; i < messagesCount; ++i)
+		dc1->send(to_string(i));
+
+	// Poll without receiving, the queue fills up and the rest must be held back, not dropped
+	poll(2s);
+	cout << "Available amount after polling: " << getDc2()->availableAmount() << endl;
+
+	vector<int> received;
+	const auto endTime = chrono::steady_clock::now() + 10s;
+	while (received.size() < messagesCount && chrono::steady_clock::now() < endTime) {
+		poll(10ms);
+		while (auto message = getDc2()->receive()) {
+			if (!holds_alternative<string>(*message))
+				throw runtime_error("Unexpected binary message");
+
+			received.push_back(stoi(get<string>(*message)));
+		}
+	}
+
+	pc1.close();
+	pc2.close();
+
+	cout << "Received " << received.size() << " messages" << endl;
+	if (received.size() != messagesCount)
+		throw runtime_error("Not all messages were received");
+
+	for (int i = 0; i < messagesCount; ++i)
+		if (received[i] != i)
+			throw runtime_error("Messages are out of order");
+
+	cout << "Success" << endl;
+}
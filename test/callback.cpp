@@ -0,0 +1,117 @@
+/**
+ * Copyright (c) 2021 Paul-Louis Ageneau
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "rtc/rtc.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace rtc;
+using namespace std;
+using namespace std::chrono_literals;
+
+void test_callback() {
+	synchronized_callback<int> callback;
+	atomic<size_t> invokedCount = 0;
+	atomic<size_t> retiredCount = 0;
+
+	// Each function checks it is not invoked after the replacement returned
+	auto makeFunction = [&invokedCount, &retiredCount](shared_ptr<atomic<bool>> retired) {
+		return [&invokedCount, &retiredCount, retired](int) {
+			// Keep the flag alive on the stack, the function must not be deleted while running
+			auto flag = retired;
+			if (*flag)
+				++retiredCount;
+
+			this_thread::sleep_for(10us);
+			if (*flag)
+				++retiredCount;
+
+			++invokedCount;
+		};
+	};
+
+	// Invocations nested deeper than the hazard slots are counted instead, cover both
+	const size_t nestingCount = callback_thread_state::HazardsCount + 2;
+	vector<synchronized_callback<int>> nesting(nestingCount);
+	for (size_t i = 0; i < nestingCount; ++i)
+		nesting[i] = [&nesting, &callback, i](int depth) {
+			if (i + 1 < nestingCount)
+				nesting[i + 1](depth);
+			else
+				callback(depth);
+		};
+
+	// Invoke from several threads while replacing the callback, once with each kind of invocation
+	for (bool nested : {false, true}) {
+		auto retired = make_shared<atomic<bool>>(false);
+		callback = makeFunction(retired);
+
+		atomic<bool> running = true;
+		vector<thread> invokers;
+		for (int i = 0; i < 4; ++i)
+			invokers.emplace_back([&running, &callback, &nesting, nested]() {
+				while (running) {
+					if (nested)
+						nesting[0](0);
+					else
+						callback(0);
+				}
+			});
+
+		size_t replacedCount = 0;
+		invokedCount = 0;
+		const auto endTime = chrono::steady_clock::now() + 1s;
+		while (chrono::steady_clock::now() < endTime) {
+			auto next = make_shared<atomic<bool>>(false);
+			callback = makeFunction(next);
+			*retired = true;
+			retired = std::move(next);
+			++replacedCount;
+		}
+
+		running = false;
+		for (auto &t : invokers)
+			t.join();
+
+		cout << (nested ? "Nested callback" : "Callback") << " invoked " << invokedCount
+		     << " times, replaced " << replacedCount << " times" << endl;
+
+		if (invokedCount == 0 || replacedCount == 0)
+			throw runtime_error("Callback was not invoked or replaced");
+
+		if (retiredCount > 0)
+			throw runtime_error("Callback was invoked after being replaced");
+	}
+
+	// Replacing the callback from inside must not wait for itself, and the previous function must
+	// be deleted once the invocation returns
+	auto token = make_shared<int>(0);
+	weak_ptr<int> weakToken = token;
+	callback = [&callback, token = std::move(token)](int) { callback = nullptr; };
+	callback(0);
+	if (!weakToken.expired())
+		throw runtime_error("Callback replaced during its invocation was not deleted");
+
+	if (callback)
+		throw runtime_error("Callback was not replaced during its invocation");
+}
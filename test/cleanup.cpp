@@ -0,0 +1,81 @@
+/**
+ * Copyright (c) 2021 Paul-Louis Ageneau
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "rtc/rtc.hpp"
+
+#include <chrono>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <thread>
+
+using namespace rtc;
+using namespace std;
+using namespace std::chrono_literals;
+
+void test_cleanup() {
+	InitLogger(LogLevel::Warning);
+
+	{
+		PeerConnection pc1;
+		PeerConnection pc2;
+
+		pc1.onLocalDescription(
+		    [&pc2](Description sdp) { pc2.setRemoteDescription(std::move(sdp)); });
+		pc1.onLocalCandidate(
+		    [&pc2](Candidate candidate) { pc2.addRemoteCandidate(std::move(candidate)); });
+		pc2.onLocalDescription(
+		    [&pc1](Description sdp) { pc1.setRemoteDescription(std::move(sdp)); });
+		pc2.onLocalCandidate(
+		    [&pc1](Candidate candidate) { pc1.addRemoteCandidate(std::move(candidate)); });
+
+		shared_ptr<DataChannel> dc2;
+		pc2.onDataChannel([&dc2](shared_ptr<DataChannel> dc) { std::atomic_store(&dc2, dc); });
+
+		auto dc1 = pc1.createDataChannel("test");
+
+		int attempts = 10;
+		while ((!dc1->isOpen() || !std::atomic_load(&dc2)) && attempts--)
+			this_thread::sleep_for(1s);
+
+		if (!dc1->isOpen() || !std::atomic_load(&dc2))
+			throw runtime_error("DataChannel is not open");
+
+		// Close with an established SCTP association, which is freed by usrsctp timers
+		pc1.close();
+		pc2.close();
+		std::atomic_store(&dc2, shared_ptr<DataChannel>());
+	}
+
+	// The last token is released, so the global cleanup starts in the background
+	Cleanup();
+	this_thread::sleep_for(1s);
+
+	// Initialization waits for the cleanup to complete, run it on a thread in case it hangs
+	promise<void> initialized;
+	auto future = initialized.get_future();
+	std::thread([initialized = std::move(initialized)]() mutable {
+		Preload();
+		initialized.set_value();
+	}).detach();
+
+	if (future.wait_for(10s) != future_status::ready)
+		throw runtime_error("Global cleanup did not complete after closing a connection");
+
+	cout << "Success" << endl;
+}
@@ -0,0 +1,133 @@
+/**
+ * Copyright (c) 2021 Paul-Louis Ageneau
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "rtc/rtc.hpp"
+
+// Built as a separate C++20 target, as the tests and the library are C++17
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+
+#include <chrono>
+#include <coroutine>
+#include <exception>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <thread>
+
+using namespace rtc;
+using namespace std;
+using namespace std::chrono_literals;
+
+// Minimal eager coroutine type, errors are reported through the promise of the caller
+struct task {
+	struct promise_type {
+		task get_return_object() { return {}; }
+		suspend_never initial_suspend() noexcept { return {}; }
+		suspend_never final_suspend() noexcept { return {}; }
+		void return_void() {}
+		void unhandled_exception() { terminate(); }
+	};
+};
+
+// Sends back the first message received
+task echo(shared_ptr<DataChannel> dc, shared_ptr<promise<void>> done) {
+	try {
+		auto message = co_await coro::receive(dc);
+		co_await coro::send(dc, std::move(message));
+		done->set_value();
+	} catch (...) {
+		done->set_exception(current_exception());
+	}
+}
+
+task roundTrip(shared_ptr<DataChannel> dc, string text, shared_ptr<promise<string>> result) {
+	try {
+		co_await coro::open(dc);
+		co_await coro::send(dc, text);
+		auto message = co_await coro::receive(dc);
+		if (!holds_alternative<string>(message))
+			throw runtime_error("Received a binary message");
+
+		result->set_value(get<string>(message));
+	} catch (...) {
+		result->set_exception(current_exception());
+	}
+}
+
+void test_coroutine() {
+	InitLogger(LogLevel::Warning);
+
+	auto pc1 = make_shared<PeerConnection>();
+	auto pc2 = make_shared<PeerConnection>();
+	weak_ptr<PeerConnection> wpc1 = pc1, wpc2 = pc2;
+
+	pc1->onLocalDescription([wpc2](Description sdp) {
+		if (auto pc2 = wpc2.lock())
+			pc2->setRemoteDescription(string(sdp));
+	});
+	pc1->onLocalCandidate([wpc2](Candidate candidate) {
+		if (auto pc2 = wpc2.lock())
+			pc2->addRemoteCandidate(string(candidate));
+	});
+	pc2->onLocalDescription([wpc1](Description sdp) {
+		if (auto pc1 = wpc1.lock())
+			pc1->setRemoteDescription(string(sdp));
+	});
+	pc2->onLocalCandidate([wpc1](Candidate candidate) {
+		if (auto pc1 = wpc1.lock())
+			pc1->addRemoteCandidate(string(candidate));
+	});
+
+	auto echoed = make_shared<promise<void>>();
+	pc2->onDataChannel([echoed](shared_ptr<DataChannel> dc) { echo(dc, echoed); });
+
+	auto result = make_shared<promise<string>>();
+	auto future = result->get_future();
+	auto dc1 = pc1->createDataChannel("test");
+	roundTrip(dc1, "Hello", result);
+
+	if (future.wait_for(10s) != future_status::ready)
+		throw runtime_error("Message was not echoed");
+
+	if (future.get() != "Hello")
+		throw runtime_error("Echoed message is incorrect");
+
+	echoed->get_future().get(); // rethrows a failure of the echo
+
+	pc1->close();
+	pc2->close();
+
+	cout << "Success" << endl;
+}
+
+#ifdef COROUTINE_MAIN
+int main() {
+	try {
+		cout << endl << "*** Running coroutine test..." << endl;
+		test_coroutine();
+		cout << "*** Finished coroutine test" << endl;
+	} catch (const exception &e) {
+		cerr << "Coroutine test failed: " << e.what() << endl;
+		return -1;
+	}
+	this_thread::sleep_for(1s);
+	return 0;
+}
+#endif
+
+#endif
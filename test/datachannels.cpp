@@ -0,0 +1,112 @@
+/**
+ * Copyright (c) 2021 Paul-Louis Ageneau
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "rtc/rtc.hpp"
+
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+using namespace rtc;
+using namespace std;
+
+namespace {
+
+void expect_ids(const vector<shared_ptr<DataChannel>> &channels, const vector<uint16_t> &ids) {
+	if (channels.size() != ids.size())
+		throw runtime_error("Wrong number of DataChannels created");
+
+	for (size_t i = 0; i < ids.size(); ++i)
+		if (channels[i]->id() != ids[i])
+			throw runtime_error("DataChannel has id " + to_string(channels[i]->id()) +
+			                    ", expected " + to_string(ids[i]));
+}
+
+} // namespace
+
+void test_datachannels() {
+	InitLogger(LogLevel::Warning);
+
+	// Creating no channels must not trigger the negotiation
+	{
+		PeerConnection pc;
+		if (!pc.createDataChannels({}).empty())
+			throw runtime_error("DataChannels created without labels");
+
+		if (pc.localDescription())
+			throw runtime_error("Negotiation started without DataChannels");
+	}
+
+	Configuration config;
+	config.disableAutoNegotiation = true;
+	PeerConnection pc(config);
+	vector<shared_ptr<DataChannel>> channels; // keep the ids in use
+
+	// Without ICE transport, the offerer is passive and allocates odd ids, skipping used ones
+	auto allocated = pc.createDataChannels({"a", "b", "c"});
+	expect_ids(allocated, {1, 3, 5});
+	channels.insert(channels.end(), allocated.begin(), allocated.end());
+
+	channels.push_back(pc.createDataChannel("d"));
+	expect_ids({channels.back()}, {7});
+
+	allocated = pc.createDataChannels({"e", "f"});
+	expect_ids(allocated, {9, 11});
+	channels.insert(channels.end(), allocated.begin(), allocated.end());
+
+	// With an id, the ids are consecutive
+	DataChannelInit init;
+	init.negotiated = true;
+	init.id = 100;
+	allocated = pc.createDataChannels({"g", "h", "i"}, init);
+	expect_ids(allocated, {100, 101, 102});
+	channels.insert(channels.end(), allocated.begin(), allocated.end());
+
+	init.id = 105;
+	channels.push_back(pc.createDataChannels({"j"}, init).front());
+
+	// 103 and 104 are free but 105 is used, nothing must be created
+	init.id = 103;
+	bool thrown = false;
+	try {
+		pc.createDataChannels({"k", "l", "m"}, init);
+	} catch (const invalid_argument &e) {
+		cout << "Expected error: " << e.what() << endl;
+		thrown = true;
+	}
+	if (!thrown)
+		throw runtime_error("No error for a DataChannel id in use");
+
+	allocated = pc.createDataChannels({"k", "l"}, init);
+	expect_ids(allocated, {103, 104});
+	channels.insert(channels.end(), allocated.begin(), allocated.end());
+
+	init.id = 65534;
+	thrown = false;
+	try {
+		pc.createDataChannels({"n", "o"}, init);
+	} catch (const invalid_argument &) {
+		thrown = true;
+	}
+	if (!thrown)
+		throw runtime_error("No error for an invalid DataChannel id");
+
+	pc.close();
+	cout << "Success" << endl;
+}
@@ -0,0 +1,152 @@
+/**
+ * Copyright (c) 2021 Paul-Louis Ageneau
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "rtc/rtc.hpp"
+
+#if RTC_ENABLE_MEDIA
+#include "rtc/rtp.hpp"
+#endif
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+using namespace rtc;
+using namespace std;
+using namespace std::chrono_literals;
+
+void test_in_process() {
+	InitLogger(LogLevel::Warning);
+
+	// Pinned connections process everything on their loop thread, so in-process messages must be
+	// received there rather than on the global thread pool
+	Configuration config;
+	config.enableInProcessTransport = true;
+	config.pinToLoopThread = true;
+
+	PeerConnection pc1(config);
+	PeerConnection pc2(config);
+
+	pc1.onLocalDescription([&pc2](Description sdp) { pc2.setRemoteDescription(std::move(sdp)); });
+	pc1.onLocalCandidate(
+	    [&pc2](Candidate candidate) { pc2.addRemoteCandidate(std::move(candidate)); });
+	pc2.onLocalDescription([&pc1](Description sdp) { pc1.setRemoteDescription(std::move(sdp)); });
+	pc2.onLocalCandidate(
+	    [&pc1](Candidate candidate) { pc1.addRemoteCandidate(std::move(candidate)); });
+
+	std::mutex mutex;
+	optional<thread::id> loopThread, mediaThread;
+	pc2.onStateChange([&mutex, &loopThread](PeerConnection::State state) {
+		if (state == PeerConnection::State::Connected) {
+			std::lock_guard lock(mutex);
+			loopThread = this_thread::get_id();
+		}
+	});
+
+#if RTC_ENABLE_MEDIA
+	// Media is received synchronously on the thread draining the in-process queue
+	shared_ptr<Track> t2;
+	pc2.onTrack([&t2, &mutex, &mediaThread](shared_ptr<Track> t) {
+		t->onMessage([&mutex, &mediaThread](message_variant message) {
+			if (!holds_alternative<binary>(message))
+				return;
+
+			std::lock_guard lock(mutex);
+			if (!mediaThread)
+				mediaThread = this_thread::get_id();
+		});
+		std::atomic_store(&t2, t);
+	});
+
+	const uint32_t ssrc = 42;
+	Description::Video media("video", Description::Direction::SendOnly);
+	media.addH264Codec(96);
+	media.addSSRC(ssrc, "video-send");
+	auto t1 = pc1.addTrack(media);
+#endif
+
+	// Echo messages back
+	pc2.onDataChannel([](shared_ptr<DataChannel> dc) {
+		dc->onMessage([wdc = weak_ptr<DataChannel>(dc)](message_variant message) {
+			if (auto dc = wdc.lock())
+				dc->send(std::move(message));
+		});
+	});
+
+	atomic<bool> echoed = false;
+	auto dc1 = pc1.createDataChannel("test");
+	dc1->onOpen([wdc1 = weak_ptr<DataChannel>(dc1)]() {
+		if (auto dc1 = wdc1.lock())
+			dc1->send("Hello in process");
+	});
+	dc1->onMessage([&echoed](message_variant message) {
+		if (holds_alternative<string>(message) && get<string>(message) == "Hello in process")
+			echoed = true;
+	});
+
+	int attempts = 10;
+	while (!echoed && attempts--)
+		this_thread::sleep_for(1s);
+
+	if (!echoed)
+		throw runtime_error("Message was not echoed in process");
+
+#if RTC_ENABLE_MEDIA
+	attempts = 10;
+	while (!t1->isOpen() && attempts--)
+		this_thread::sleep_for(1s);
+
+	if (!t1->isOpen())
+		throw runtime_error("Track is not open");
+
+	for (int i = 0; i < 10; ++i) {
+		binary packet(200, byte(0));
+		auto rtp = reinterpret_cast<RTP *>(packet.data());
+		rtp->preparePacket();
+		rtp->setPayloadType(96);
+		rtp->setSsrc(ssrc);
+		rtp->setSeqNumber(uint16_t(i));
+		t1->send(std::move(packet));
+	}
+
+	attempts = 10;
+	while (attempts--) {
+		this_thread::sleep_for(100ms);
+		std::lock_guard lock(mutex);
+		if (mediaThread)
+			break;
+	}
+
+	{
+		std::lock_guard lock(mutex);
+		if (!mediaThread)
+			throw runtime_error("No media received in process");
+
+		if (!loopThread || *mediaThread != *loopThread)
+			throw runtime_error("In-process media was not received on the loop thread");
+	}
+#endif
+
+	pc1.close();
+	pc2.close();
+
+	cout << "Success" << endl;
+}
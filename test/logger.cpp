@@ -0,0 +1,79 @@
+/**
+ * Copyright (c) 2021 Paul-Louis Ageneau
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "rtc/rtc.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+using namespace rtc;
+using namespace std;
+using namespace std::chrono_literals;
+
+void test_logger() {
+	// The synchronous console logger is installed first, the asynchronous one must replace it
+	InitLogger(LogLevel::Warning);
+
+	std::mutex mutex;
+	vector<string> messages;
+	atomic<bool> callerThread = false;
+	const auto callerId = this_thread::get_id();
+	InitAsyncLogger(LogLevel::Debug, [&](LogLevel, string message) {
+		if (this_thread::get_id() == callerId)
+			callerThread = true;
+
+		std::lock_guard lock(mutex);
+		messages.push_back(std::move(message));
+	});
+
+	// Nothing may be written to the console by the logging thread anymore
+	std::ostringstream console;
+	auto previous = cout.rdbuf(console.rdbuf());
+	Preload(); // logs the global initialization
+	cout.rdbuf(previous);
+
+	const auto endTime = chrono::steady_clock::now() + 5s;
+	size_t count = 0;
+	while (count == 0 && chrono::steady_clock::now() < endTime) {
+		this_thread::sleep_for(10ms);
+		std::lock_guard lock(mutex);
+		count = messages.size();
+	}
+
+	// Stop calling the callback before its captures go out of scope, then restore the synchronous
+	// logger for the following tests
+	InitAsyncLogger(LogLevel::Warning);
+	InitLogger(LogLevel::Warning);
+	Cleanup();
+
+	if (count == 0)
+		throw runtime_error("No message logged asynchronously");
+
+	if (callerThread)
+		throw runtime_error("Asynchronous logger called the callback on the logging thread");
+
+	if (console.str().find("Global initialization") != string::npos)
+		throw runtime_error("Message was also written synchronously to the console");
+
+	cout << "Logged " << count << " messages asynchronously" << endl;
+}
@@ -0,0 +1,94 @@
+/**
+ * Copyright (c) 2021 Paul-Louis Ageneau
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "rtc/rtc.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <thread>
+
+using namespace rtc;
+using namespace std;
+using namespace std::chrono_literals;
+
+void test_loop_release() {
+	InitLogger(LogLevel::Warning);
+
+	Configuration config;
+	config.pinToLoopThread = true;
+	auto pc1 = make_shared<PeerConnection>(config);
+	auto pc2 = make_shared<PeerConnection>(config);
+	weak_ptr<PeerConnection> wpc1 = pc1, wpc2 = pc2;
+
+	pc1->onLocalDescription([wpc2](Description sdp) {
+		if (auto pc2 = wpc2.lock())
+			pc2->setRemoteDescription(string(sdp));
+	});
+	pc1->onLocalCandidate([wpc2](Candidate candidate) {
+		if (auto pc2 = wpc2.lock())
+			pc2->addRemoteCandidate(string(candidate));
+	});
+	pc2->onLocalDescription([wpc1](Description sdp) {
+		if (auto pc1 = wpc1.lock())
+			pc1->setRemoteDescription(string(sdp));
+	});
+	pc2->onLocalCandidate([wpc1](Candidate candidate) {
+		if (auto pc1 = wpc1.lock())
+			pc1->addRemoteCandidate(string(candidate));
+	});
+
+	// Drop the last reference to the connection from a callback running on its loop thread,
+	// destroying it there must not wait for the loop itself
+	atomic<bool> released = false;
+	pc2->onDataChannel([&pc2, &released](shared_ptr<DataChannel> dc) {
+		dc->onMessage([&pc2, &released](variant<binary, string>) {
+			auto pc = std::atomic_exchange(&pc2, shared_ptr<PeerConnection>());
+			pc.reset();
+			released = true;
+		});
+	});
+
+	auto dc1 = pc1->createDataChannel("test");
+	dc1->onOpen([wdc1 = weak_ptr<DataChannel>(dc1)]() {
+		if (auto dc1 = wdc1.lock())
+			dc1->send("Hello from 1");
+	});
+
+	int attempts = 10;
+	while (!released && attempts--)
+		this_thread::sleep_for(1s);
+
+	if (!released)
+		throw runtime_error("Connection was not released from its loop thread");
+
+	if (!wpc2.expired())
+		throw runtime_error("Connection was not destroyed");
+
+	// The loop must still process the remaining connection
+	pc1->close();
+	attempts = 10;
+	while (pc1->state() != PeerConnection::State::Closed && attempts--)
+		this_thread::sleep_for(1s);
+
+	if (pc1->state() != PeerConnection::State::Closed)
+		throw runtime_error("Loop thread is blocked");
+
+	cout << "Success" << endl;
+}
@@ -23,11 +23,25 @@
 using namespace std;
 using namespace chrono_literals;
 
+void test_callback();
+void test_logger();
+void test_datachannels();
+void test_numa();
+void test_zero_checksum();
 void test_connectivity();
+void test_cleanup();
+void test_many_close();
+void test_loop_release();
+void test_in_process();
+void test_parallel_datachannels();
+void test_busy_polling();
 void test_turn_connectivity();
 void test_track();
 void test_capi_connectivity();
 void test_capi_track();
+void test_media_priority();
+void test_rtcp_feedback();
+void test_rtpbridge();
 void test_websocket();
 void test_websocketserver();
 void test_capi_websocketserver();
@@ -45,6 +59,46 @@ void test_benchmark() {
 }
 
 int main(int argc, char **argv) {
+	try {
+		cout << endl << "*** Running callback test..." << endl;
+		test_callback();
+		cout << "*** Finished callback test" << endl;
+	} catch (const exception &e) {
+		cerr << "Callback test failed: " << e.what() << endl;
+		return -1;
+	}
+	try {
+		cout << endl << "*** Running logger test..." << endl;
+		test_logger();
+		cout << "*** Finished logger test" << endl;
+	} catch (const exception &e) {
+		cerr << "Logger test failed: " << e.what() << endl;
+		return -1;
+	}
+	try {
+		cout << endl << "*** Running DataChannels creation test..." << endl;
+		test_datachannels();
+		cout << "*** Finished DataChannels creation test" << endl;
+	} catch (const exception &e) {
+		cerr << "DataChannels creation test failed: " << e.what() << endl;
+		return -1;
+	}
+	try {
+		cout << endl << "*** Running NUMA topology test..." << endl;
+		test_numa();
+		cout << "*** Finished NUMA topology test" << endl;
+	} catch (const exception &e) {
+		cerr << "NUMA topology test failed: " << e.what() << endl;
+		return -1;
+	}
+	try {
+		cout << endl << "*** Running SCTP zero checksum test..." << endl;
+		test_zero_checksum();
+		cout << "*** Finished SCTP zero checksum test" << endl;
+	} catch (const exception &e) {
+		cerr << "SCTP zero checksum test failed: " << e.what() << endl;
+		return -1;
+	}
 	try {
 		cout << endl << "*** Running WebRTC connectivity test..." << endl;
 		test_connectivity();
@@ -53,6 +107,54 @@ int main(int argc, char **argv) {
 		cerr << "WebRTC connectivity test failed: " << e.what() << endl;
 		return -1;
 	}
+	try {
+		cout << endl << "*** Running global cleanup test..." << endl;
+		test_cleanup();
+		cout << "*** Finished global cleanup test" << endl;
+	} catch (const exception &e) {
+		cerr << "Global cleanup test failed: " << e.what() << endl;
+		return -1;
+	}
+	try {
+		cout << endl << "*** Running many connections close test..." << endl;
+		test_many_close();
+		cout << "*** Finished many connections close test" << endl;
+	} catch (const exception &e) {
+		cerr << "Many connections close test failed: " << e.what() << endl;
+		return -1;
+	}
+	try {
+		cout << endl << "*** Running loop release test..." << endl;
+		test_loop_release();
+		cout << "*** Finished loop release test" << endl;
+	} catch (const exception &e) {
+		cerr << "Loop release test failed: " << e.what() << endl;
+		return -1;
+	}
+	try {
+		cout << endl << "*** Running in-process transport test..." << endl;
+		test_in_process();
+		cout << "*** Finished in-process transport test" << endl;
+	} catch (const exception &e) {
+		cerr << "In-process transport test failed: " << e.what() << endl;
+		return -1;
+	}
+	try {
+		cout << endl << "*** Running parallel DataChannels test..." << endl;
+		test_parallel_datachannels();
+		cout << "*** Finished parallel DataChannels test" << endl;
+	} catch (const exception &e) {
+		cerr << "Parallel DataChannels test failed: " << e.what() << endl;
+		return -1;
+	}
+	try {
+		cout << endl << "*** Running busy-polling test..." << endl;
+		test_busy_polling();
+		cout << "*** Finished busy-polling test" << endl;
+	} catch (const exception &e) {
+		cerr << "Busy-polling test failed: " << e.what() << endl;
+		return -1;
+	}
 	this_thread::sleep_for(1s);
 	try {
 		cout << endl << "*** Running WebRTC TURN connectivity test..." << endl;
@@ -89,6 +191,30 @@ int main(int argc, char **argv) {
 		cerr << "WebRTC C API track test failed: " << e.what() << endl;
 		return -1;
 	}
+	try {
+		cout << endl << "*** Running media priority test..." << endl;
+		test_media_priority();
+		cout << "*** Finished media priority test" << endl;
+	} catch (const exception &e) {
+		cerr << "Media priority test failed: " << e.what() << endl;
+		return -1;
+	}
+	try {
+		cout << endl << "*** Running RTCP feedback test..." << endl;
+		test_rtcp_feedback();
+		cout << "*** Finished RTCP feedback test" << endl;
+	} catch (const exception &e) {
+		cerr << "RTCP feedback test failed: " << e.what() << endl;
+		return -1;
+	}
+	try {
+		cout << endl << "*** Running RTP bridge test..." << endl;
+		test_rtpbridge();
+		cout << "*** Finished RTP bridge test" << endl;
+	} catch (const exception &e) {
+		cerr << "RTP bridge test failed: " << e.what() << endl;
+		return -1;
+	}
 #endif
 #if RTC_ENABLE_WEBSOCKET
 // TODO: Temporarily disabled as the echo service is unreliable
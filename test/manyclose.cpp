@@ -0,0 +1,176 @@
+/**
+ * Copyright (c) 2021 Paul-Louis Ageneau
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+#include "rtc/rtc.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace rtc;
+using namespace std;
+using namespace std::chrono_literals;
+
+template <class T> weak_ptr<T> make_weak_ptr(shared_ptr<T> ptr) { return ptr; }
+
+namespace {
+
+const int PairsCount = 16;
+const int PingsCount = 10;
+
+struct Pair {
+	shared_ptr<PeerConnection> pc1;
+	shared_ptr<PeerConnection> pc2;
+	shared_ptr<DataChannel> dc1;
+	shared_ptr<DataChannel> dc2;
+};
+
+Pair createPair(string label) {
+	Pair pair;
+	pair.pc1 = make_shared<PeerConnection>();
+	pair.pc2 = make_shared<PeerConnection>();
+
+	auto wpc1 = make_weak_ptr(pair.pc1);
+	auto wpc2 = make_weak_ptr(pair.pc2);
+	pair.pc1->onLocalDescription([wpc2](Description sdp) {
+		if (auto pc2 = wpc2.lock())
+			pc2->setRemoteDescription(std::move(sdp));
+	});
+	pair.pc1->onLocalCandidate([wpc2](Candidate candidate) {
+		if (auto pc2 = wpc2.lock())
+			pc2->addRemoteCandidate(std::move(candidate));
+	});
+	pair.pc2->onLocalDescription([wpc1](Description sdp) {
+		if (auto pc1 = wpc1.lock())
+			pc1->setRemoteDescription(std::move(sdp));
+	});
+	pair.pc2->onLocalCandidate([wpc1](Candidate candidate) {
+		if (auto pc1 = wpc1.lock())
+			pc1->addRemoteCandidate(std::move(candidate));
+	});
+
+	pair.dc1 = pair.pc1->createDataChannel(std::move(label));
+	return pair;
+}
+
+bool isOpen(const Pair &pair) {
+	auto dc2 = std::atomic_load(&pair.dc2);
+	return pair.dc1->isOpen() && dc2 && dc2->isOpen();
+}
+
+bool isClosed(const Pair &pair) {
+	auto dc2 = std::atomic_load(&pair.dc2);
+	return pair.pc1->state() == PeerConnection::State::Closed &&
+	       pair.pc2->state() == PeerConnection::State::Closed && pair.dc1->isClosed() && dc2 &&
+	       dc2->isClosed();
+}
+
+bool waitPongs(const atomic<int> &pongs, int expected) {
+	int attempts = 50;
+	while (pongs < expected && attempts--)
+		this_thread::sleep_for(100ms);
+
+	return pongs >= expected;
+}
+
+} // namespace
+
+void test_many_close() {
+	InitLogger(LogLevel::Warning);
+
+	// The live pair echoes pings while the other connections are closed
+	auto live = createPair("live");
+	live.pc2->onDataChannel([&live](shared_ptr<DataChannel> dc) {
+		dc->onMessage([wdc = make_weak_ptr(dc)](variant<binary, string> message) {
+			if (auto dc = wdc.lock())
+				dc->send(std::move(message));
+		});
+		std::atomic_store(&live.dc2, dc);
+	});
+
+	atomic<int> pongs = 0;
+	live.dc1->onMessage([&pongs](variant<binary, string>) { ++pongs; });
+
+	vector<Pair> pairs;
+	pairs.reserve(PairsCount); // callbacks keep references to the elements
+	for (int i = 0; i < PairsCount; ++i) {
+		pairs.push_back(createPair("test-" + to_string(i)));
+		auto &pair = pairs.back();
+		pair.pc2->onDataChannel(
+		    [&pair](shared_ptr<DataChannel> dc) { std::atomic_store(&pair.dc2, dc); });
+	}
+
+	int attempts = 30;
+	auto allOpen = [&]() {
+		if (!isOpen(live))
+			return false;
+		for (auto &pair : pairs)
+			if (!isOpen(pair))
+				return false;
+		return true;
+	};
+	while (!allOpen() && attempts--)
+		this_thread::sleep_for(1s);
+
+	if (!allOpen())
+		throw runtime_error("DataChannels are not open");
+
+	cout << "Closing " << PairsCount << " connection pairs" << endl;
+
+	// Close everything at once, transports are stopped in the background
+	for (auto &pair : pairs) {
+		pair.pc1->close();
+		pair.pc2->close();
+	}
+
+	// The live connection must keep working while the closed transports are stopped
+	for (int i = 0; i < PingsCount; ++i) {
+		live.dc1->send("ping");
+		if (!waitPongs(pongs, i + 1))
+			throw runtime_error("Live DataChannel stalled while closing connections");
+	}
+
+	auto allClosed = [&]() {
+		for (auto &pair : pairs)
+			if (!isClosed(pair))
+				return false;
+		return true;
+	};
+	attempts = 10;
+	while (!allClosed() && attempts--)
+		this_thread::sleep_for(1s);
+
+	if (!allClosed())
+		throw runtime_error("Connections are not closed");
+
+	// Releasing the closed connections must not disturb the live one either
+	pairs.clear();
+
+	live.dc1->send("ping");
+	if (!waitPongs(pongs, PingsCount + 1))
+		throw runtime_error("Live DataChannel stalled after releasing connections");
+
+	live.pc1->close();
+	live.pc2->close();
+	std::atomic_store(&live.dc2, shared_ptr<DataChannel>());
+
+	cout << "Success" << endl;
+}
@@ -0,0 +1,182 @@
+/**
+ * Copyright (c) 2021 Paul-Louis Ageneau
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "rtc/rtc.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace rtc;
+using namespace std;
+using namespace std::chrono_literals;
+
+namespace {
+
+const size_t RtpHeaderSize = 12;
+const int VideoThreadsCount = 4;
+const uint32_t VideoPacketsCount = 128; // per thread and round
+
+binary makePacket(size_t size, uint8_t payloadType, uint32_t ssrc) {
+	binary packet(size, byte(0));
+	auto rtp = reinterpret_cast<RTP *>(packet.data());
+	rtp->preparePacket();
+	rtp->setPayloadType(payloadType);
+	rtp->setSsrc(ssrc);
+	return packet;
+}
+
+} // namespace
+
+void test_media_priority() {
+	InitLogger(LogLevel::Warning);
+
+	PeerConnection pc1;
+	PeerConnection pc2;
+
+	pc1.onLocalDescription([&pc2](Description sdp) { pc2.setRemoteDescription(string(sdp)); });
+	pc1.onLocalCandidate(
+	    [&pc2](Candidate candidate) { pc2.addRemoteCandidate(string(candidate)); });
+	pc2.onLocalDescription([&pc1](Description sdp) { pc1.setRemoteDescription(string(sdp)); });
+	pc2.onLocalCandidate(
+	    [&pc1](Candidate candidate) { pc1.addRemoteCandidate(string(candidate)); });
+
+	// Video packets carry the index of their sending thread and their sequence in the thread, audio
+	// packets carry how many video packets each thread had sent or queued when they were sent
+	std::mutex mutex;
+	array<uint32_t, VideoThreadsCount> videoReceived = {};
+	int audioReceived = 0;
+	int overtakes = 0;
+	vector<shared_ptr<Track>> remoteTracks;
+	pc2.onTrack([&](shared_ptr<Track> t) {
+		bool isAudio = t->description().type() == "audio";
+		t->onMessage([&, isAudio](message_variant message) {
+			if (!holds_alternative<binary>(message))
+				return;
+
+			const auto &packet = get<binary>(message);
+			std::lock_guard lock(mutex);
+			if (isAudio) {
+				if (packet.size() < RtpHeaderSize + sizeof(videoReceived))
+					return;
+
+				array<uint32_t, VideoThreadsCount> videoSent;
+				std::memcpy(videoSent.data(), packet.data() + RtpHeaderSize, sizeof(videoSent));
+				++audioReceived;
+				for (int i = 0; i < VideoThreadsCount; ++i)
+					if (videoReceived[i] < videoSent[i]) {
+						++overtakes; // sent before video the other threads had queued earlier
+						break;
+					}
+			} else {
+				if (packet.size() < RtpHeaderSize + 2 * sizeof(uint32_t))
+					return;
+
+				uint32_t index, seq;
+				std::memcpy(&index, packet.data() + RtpHeaderSize, sizeof(index));
+				std::memcpy(&seq, packet.data() + RtpHeaderSize + sizeof(index), sizeof(seq));
+				if (index < VideoThreadsCount)
+					videoReceived[index] = std::max(videoReceived[index], seq + 1);
+			}
+		});
+
+		std::lock_guard lock(mutex);
+		remoteTracks.push_back(t);
+	});
+
+	Description::Audio audio("audio", Description::Direction::SendOnly);
+	audio.addOpusCodec(111);
+	audio.addSSRC(1, "audio-send");
+	auto audioTrack = pc1.addTrack(audio);
+
+	Description::Video video("video", Description::Direction::SendOnly);
+	video.addH264Codec(96);
+	video.addSSRC(2, "video-send");
+	auto videoTrack = pc1.addTrack(video);
+
+	pc1.setLocalDescription();
+
+	int attempts = 10;
+	while ((!audioTrack->isOpen() || !videoTrack->isOpen()) && attempts--)
+		this_thread::sleep_for(1s);
+
+	if (!audioTrack->isOpen() || !videoTrack->isOpen())
+		throw runtime_error("Tracks are not open");
+
+	// A backlog only builds up when several threads send at once, so retry a few rounds
+	array<atomic<uint32_t>, VideoThreadsCount> videoSent = {};
+	int rounds = 0;
+	while (rounds++ < 5) {
+		atomic<int> running = VideoThreadsCount;
+		vector<thread> videoThreads;
+		for (int i = 0; i < VideoThreadsCount; ++i) {
+			videoThreads.emplace_back([&, i]() {
+				auto packet = makePacket(RtpHeaderSize + 100, 96, 2);
+				uint32_t index = uint32_t(i);
+				std::memcpy(packet.data() + RtpHeaderSize, &index, sizeof(index));
+				for (uint32_t n = 0; n < VideoPacketsCount; ++n) {
+					uint32_t seq = videoSent[i].load();
+					std::memcpy(packet.data() + RtpHeaderSize + sizeof(index), &seq, sizeof(seq));
+					videoTrack->send(packet);
+					videoSent[i] = seq + 1;
+				}
+				--running;
+			});
+		}
+
+		while (running > 0) {
+			auto packet = makePacket(RtpHeaderSize + 4 * VideoThreadsCount, 111, 1);
+			for (int i = 0; i < VideoThreadsCount; ++i) {
+				uint32_t sent = videoSent[i].load();
+				std::memcpy(packet.data() + RtpHeaderSize + i * sizeof(sent), &sent, sizeof(sent));
+			}
+			audioTrack->send(std::move(packet));
+			this_thread::yield();
+		}
+
+		for (auto &t : videoThreads)
+			t.join();
+
+		this_thread::sleep_for(500ms);
+
+		std::lock_guard lock(mutex);
+		if (overtakes > 0)
+			break;
+	}
+
+	pc1.close();
+	pc2.close();
+	this_thread::sleep_for(1s);
+
+	std::lock_guard lock(mutex);
+	if (audioReceived == 0)
+		throw runtime_error("No audio packet received");
+
+	if (overtakes == 0)
+		throw runtime_error("Audio never overtook queued video");
+
+	cout << "Audio packets received: " << audioReceived << ", sent before queued video: "
+	     << overtakes << endl;
+	cout << "Success" << endl;
+}
@@ -0,0 +1,93 @@
+/**
+ * Copyright (c) 2021 Paul-Louis Ageneau
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "impl/numa.hpp"
+
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace rtc::impl;
+using namespace std;
+
+void test_numa() {
+	if (parse_cpu_list("0-3,8,10-11") != vector<int>{0, 1, 2, 3, 8, 10, 11})
+		throw runtime_error("Failed to parse CPU list");
+
+	if (!parse_cpu_list("").empty() || !parse_cpu_list("a-b").empty())
+		throw runtime_error("Parsed an invalid CPU list");
+
+#ifdef __linux__
+	// Inject a topology with two nodes and a memory-only node
+	char root[] = "/tmp/rtc-numa-XXXXXX";
+	if (!mkdtemp(root))
+		throw runtime_error("Failed to create temporary directory");
+
+	const string path = root;
+	auto write = [&path](const string &name, const string &content) {
+		ofstream(path + "/" + name) << content << endl;
+	};
+	for (const char *node : {"node0", "node1", "node2"})
+		mkdir((path + "/" + node).c_str(), 0700);
+
+	write("online", "0-2");
+	write("node0/cpulist", "0-1");
+	write("node1/cpulist", "2-3,6-7");
+	write("node2/cpulist", "");
+
+	// CPU 7 is not allowed by the affinity mask
+	auto nodes = read_numa_nodes(path, {0, 1, 2, 3, 6});
+
+	for (const char *name : {"online", "node0/cpulist", "node1/cpulist", "node2/cpulist"})
+		unlink((path + "/" + name).c_str());
+	for (const char *node : {"node0", "node1", "node2"})
+		rmdir((path + "/" + node).c_str());
+	rmdir(root);
+
+	if (nodes.size() != 2 || nodes[0].id != 0 || nodes[0].cpus != vector<int>{0, 1} ||
+	    nodes[1].id != 1 || nodes[1].cpus != vector<int>{2, 3, 6})
+		throw runtime_error("Failed to read NUMA topology");
+
+	if (!read_numa_nodes(path, {0, 1}).empty())
+		throw runtime_error("Read NUMA topology from a missing directory");
+
+	// One loop per CPU, connections alternate between the nodes
+	NumaLayout layout(std::move(nodes));
+	if (layout.size() != 5)
+		throw runtime_error("Wrong number of loops");
+
+	const vector<size_t> expected = {0, 2, 1, 3, 4, 0, 2};
+	for (size_t loop : expected)
+		if (layout.next() != loop)
+			throw runtime_error("Wrong loop assignment");
+
+	if (layout.node(1).cpus != vector<int>{0, 1} || layout.node(4).cpus != vector<int>{2, 3, 6})
+		throw runtime_error("Wrong loop affinity");
+
+	cout << "Success" << endl;
+#else
+	cout << "NUMA topology is only read on Linux, skipped" << endl;
+#endif
+}
@@ -0,0 +1,139 @@
+/**
+ * Copyright (c) 2021 Paul-Louis Ageneau
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "rtc/rtc.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace rtc;
+using namespace std;
+using namespace std::chrono_literals;
+
+void test_parallel_datachannels() {
+	InitLogger(LogLevel::Warning);
+
+	PeerConnection pc1;
+
+	// Callbacks of distinct channels run in parallel on the receiver
+	Configuration config2;
+	config2.enableParallelDataChannels = true;
+	PeerConnection pc2(config2);
+
+	pc1.onLocalDescription([&pc2](Description sdp) { pc2.setRemoteDescription(std::move(sdp)); });
+	pc1.onLocalCandidate(
+	    [&pc2](Candidate candidate) { pc2.addRemoteCandidate(std::move(candidate)); });
+	pc2.onLocalDescription([&pc1](Description sdp) { pc1.setRemoteDescription(std::move(sdp)); });
+	pc2.onLocalCandidate(
+	    [&pc1](Candidate candidate) { pc1.addRemoteCandidate(std::move(candidate)); });
+
+	const vector<string> labels = {"a", "b", "c"};
+	const int messagesCount = 20;
+
+	std::mutex mutex;
+	map<string, vector<int>> received;
+	vector<shared_ptr<DataChannel>> channels2; // keep the remote channels alive
+	atomic<int> active = 0, maxActive = 0;
+	atomic<bool> overlapped = false; // a channel callback ran concurrently with itself
+
+	pc2.onDataChannel([&](shared_ptr<DataChannel> dc) {
+		auto running = make_shared<atomic<bool>>(false);
+		dc->onMessage([&, label = dc->label(), running](message_variant message) {
+			if (running->exchange(true))
+				overlapped = true;
+
+			int current = ++active;
+			int previous = maxActive.load();
+			while (current > previous && !maxActive.compare_exchange_weak(previous, current)) {
+			}
+
+			this_thread::sleep_for(10ms); // slow handler
+
+			{
+				std::lock_guard lock(mutex);
+				received[label].push_back(stoi(get<string>(message)));
+			}
+
+			--active;
+			*running = false;
+		});
+
+		std::lock_guard lock(mutex);
+		channels2.push_back(dc);
+	});
+
+	vector<shared_ptr<DataChannel>> channels1;
+	for (const auto &label : labels)
+		channels1.push_back(pc1.createDataChannel(label));
+
+	int attempts = 10;
+	auto allOpen = [&channels1]() {
+		for (const auto &dc : channels1)
+			if (!dc->isOpen())
+				return false;
+		return true;
+	};
+	while (!allOpen() && attempts--)
+		this_thread::sleep_for(1s);
+
+	if (!allOpen())
+		throw runtime_error("DataChannels are not open");
+
+	// Interleave the channels so their handlers have messages to process at the same time
+	for (int i = 0; i < messagesCount; ++i)
+		for (const auto &dc : channels1)
+			dc->send(to_string(i));
+
+	auto receivedCount = [&]() {
+		std::lock_guard lock(mutex);
+		size_t count = 0;
+		for (const auto &[label, numbers] : received)
+			count += numbers.size();
+		return count;
+	};
+	attempts = 100;
+	while (receivedCount() < labels.size() * messagesCount && attempts--)
+		this_thread::sleep_for(100ms);
+
+	pc1.close();
+	pc2.close();
+
+	if (receivedCount() != labels.size() * messagesCount)
+		throw runtime_error("Not all messages were received");
+
+	std::lock_guard lock(mutex);
+	for (const auto &[label, numbers] : received)
+		for (int i = 0; i < messagesCount; ++i)
+			if (numbers.size() != size_t(messagesCount) || numbers[i] != i)
+				throw runtime_error("Messages of DataChannel \"" + label + "\" are out of order");
+
+	if (overlapped)
+		throw runtime_error("Callbacks of a DataChannel ran concurrently");
+
+	cout << "Max concurrent handlers: " << maxActive << endl;
+	if (maxActive < 2)
+		throw runtime_error("Callbacks of distinct DataChannels did not run in parallel");
+
+	cout << "Success" << endl;
+}
@@ -0,0 +1,164 @@
+/**
+ * Copyright (c) 2021 Paul-Louis Ageneau
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+#include "rtc/rtc.hpp"
+
+#if RTC_ENABLE_MEDIA
+
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+using namespace rtc;
+using namespace std;
+
+namespace {
+
+const SSRC MediaSsrc = 0x1234;
+const SSRC LocalSsrc = 0x5678;
+const uint16_t SeqNumber = 42;
+
+// Split a compound RTCP packet and return the payload type of each packet in order
+vector<uint8_t> payloadTypes(const message_ptr &message) {
+	vector<uint8_t> types;
+	size_t offset = 0;
+	while (offset < message->size()) {
+		if (message->size() - offset < sizeof(RTCP_HEADER))
+			throw runtime_error("Truncated RTCP header");
+
+		auto header = reinterpret_cast<const RTCP_HEADER *>(message->data() + offset);
+		if (header->version() != 2)
+			throw runtime_error("Bad RTCP version");
+
+		size_t length = header->lengthInBytes();
+		if (message->size() - offset < length)
+			throw runtime_error("Truncated RTCP packet");
+
+		types.push_back(header->payloadType());
+		offset += length;
+	}
+	return types;
+}
+
+message_ptr makeRtp(size_t size, SSRC ssrc, uint16_t seqNumber) {
+	auto message = make_message(size, Message::Binary);
+	auto rtp = reinterpret_cast<RTP *>(message->data());
+	rtp->preparePacket();
+	rtp->setPayloadType(96);
+	rtp->setSsrc(ssrc);
+	rtp->setSeqNumber(seqNumber);
+	return message;
+}
+
+void test_receiving_session() {
+	RtcpReceivingSession session(90000);
+
+	vector<message_ptr> sent;
+	session.onOutgoing([&sent](message_ptr message) { sent.push_back(std::move(message)); });
+
+	// Nothing to report yet, the PLI is sent alone
+	session.requestKeyframe();
+	if (sent.size() != 1 || payloadTypes(sent.back()) != vector<uint8_t>{206})
+		throw runtime_error("PLI without reception should be sent alone");
+
+	if (sent.back()->type != Message::Control)
+		throw runtime_error("RTCP feedback should be a control message");
+
+	// Once media has been received, feedback must come in a compound packet starting with an RR
+	session.incoming(makeRtp(100, MediaSsrc, SeqNumber));
+
+	session.requestKeyframe();
+	if (sent.size() != 2 || payloadTypes(sent.back()) != vector<uint8_t>{201, 206})
+		throw runtime_error("PLI should follow an RR in a single compound packet");
+
+	auto rr = reinterpret_cast<const RTCP_RR *>(sent.back()->data());
+	if (rr->header.reportCount() != 1 || rr->getReportBlock(0)->highestSeqNo() != SeqNumber)
+		throw runtime_error("RR does not report the received sequence number");
+
+	if (sent.back()->size() != RTCP_RR::SizeWithReportBlocks(1) + RTCP_PLI::Size())
+		throw runtime_error("Unexpected compound RR and PLI size");
+
+	session.requestBitrate(300000);
+	if (sent.size() != 3 || payloadTypes(sent.back()) != vector<uint8_t>{201, 206})
+		throw runtime_error("REMB should follow an RR in a single compound packet");
+
+	if (sent.back()->size() != RTCP_RR::SizeWithReportBlocks(1) + RTCP_REMB::SizeWithSSRCs(1))
+		throw runtime_error("Unexpected compound RR and REMB size");
+
+	// An incoming SR triggers the RR, with the requested bitrate in the same packet
+	auto srMessage = make_message(RTCP_SR::Size(0), Message::Control);
+	auto sr = reinterpret_cast<RTCP_SR *>(srMessage->data());
+	sr->preparePacket(MediaSsrc, 0);
+	session.incoming(srMessage);
+	if (sent.size() != 4 || payloadTypes(sent.back()) != vector<uint8_t>{201, 206})
+		throw runtime_error("SR should trigger a compound RR and REMB");
+}
+
+void test_sr_reporter() {
+	const string cname = "rtcpfeedback";
+	auto config = make_shared<RtpPacketizationConfig>(LocalSsrc, cname, 96, 90000);
+	RtcpSrReporter reporter(config);
+	reporter.startRecording();
+
+	// The SR and SDES must be appended in place to a pending control message
+	auto pli = make_message(RTCP_PLI::Size(), Message::Control);
+	reinterpret_cast<RTCP_PLI *>(pli->data())->preparePacket(MediaSsrc);
+
+	reporter.setNeedsToReport();
+	auto product = reporter.processOutgoingBinaryMessage(
+	    make_chained_messages_product(makeRtp(100, LocalSsrc, 1)), pli);
+	if (product.control != pli)
+		throw runtime_error("SR should be written into the pending control message");
+
+	if (payloadTypes(product.control) != vector<uint8_t>{206, 200, 202})
+		throw runtime_error("SR and SDES should be appended after the pending packet");
+
+	auto sr = reinterpret_cast<const RTCP_SR *>(product.control->data() + RTCP_PLI::Size());
+	if (sr->senderSSRC() != LocalSsrc || sr->packetCount() != 0)
+		throw runtime_error("Unexpected appended SR content");
+
+	auto sdes = reinterpret_cast<const RTCP_SDES *>(product.control->data() + RTCP_PLI::Size() +
+	                                                RTCP_SR::Size(0));
+	if (!sdes->isValid() || sdes->getChunk(0)->ssrc() != LocalSsrc ||
+	    sdes->getChunk(0)->getItem(0)->text() != cname)
+		throw runtime_error("Unexpected appended SDES content");
+
+	// Without a pending control message, the report is a new compound packet
+	reporter.setNeedsToReport();
+	auto next = reporter.processOutgoingBinaryMessage(
+	    make_chained_messages_product(makeRtp(100, LocalSsrc, 2)), nullptr);
+	if (!next.control || payloadTypes(next.control) != vector<uint8_t>{200, 202})
+		throw runtime_error("SR should be sent as a new SR and SDES compound packet");
+
+	sr = reinterpret_cast<const RTCP_SR *>(next.control->data());
+	if (sr->packetCount() != 1 || sr->octetCount() != 100 - 12)
+		throw runtime_error("SR does not count the packets sent before it");
+}
+
+} // namespace
+
+void test_rtcp_feedback() {
+	InitLogger(LogLevel::Warning);
+
+	test_receiving_session();
+	test_sr_reporter();
+
+	cout << "Success" << endl;
+}
+
+#endif
@@ -0,0 +1,200 @@
+/**
+ * Copyright (c) 2021 Paul-Louis Ageneau
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "rtc/rtc.hpp"
+
+#if RTC_ENABLE_MEDIA
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+using namespace rtc;
+using namespace std;
+using namespace std::chrono_literals;
+
+namespace {
+
+#ifndef _WIN32
+// Sends a burst of RTP packets over loopback UDP to a bridge, so several are received per batch,
+// and checks they are all sent on the track intact and rewritten, and received through the
+// expected path. The run is skipped if the bridge falls back to the socket.
+void test_rtpbridge_receive(RtpBridge::Configuration bridgeConfig, RtpBridge::Backend backend,
+                            const string &name) {
+	const uint32_t ssrc = 42;
+	const uint8_t payloadType = 96;
+	const size_t payloadSize = 1000;
+
+	bridgeConfig.ssrc = ssrc;
+	bridgeConfig.payloadType = payloadType;
+	auto bridge = std::make_shared<RtpBridge>(bridgeConfig);
+	if (bridge->backend() != backend) {
+		cout << name << " is unavailable, skipped" << endl;
+		return;
+	}
+
+	PeerConnection pc1;
+	PeerConnection pc2;
+
+	pc1.onLocalDescription([&pc2](Description sdp) { pc2.setRemoteDescription(std::move(sdp)); });
+	pc1.onLocalCandidate(
+	    [&pc2](Candidate candidate) { pc2.addRemoteCandidate(std::move(candidate)); });
+	pc2.onLocalDescription([&pc1](Description sdp) { pc1.setRemoteDescription(std::move(sdp)); });
+	pc2.onLocalCandidate(
+	    [&pc1](Candidate candidate) { pc1.addRemoteCandidate(std::move(candidate)); });
+
+	std::mutex mutex;
+	vector<uint16_t> received; // sequence numbers of valid packets
+	size_t invalidCount = 0;
+	pc2.onTrack([&](shared_ptr<Track> t) {
+		t->onMessage([&](message_variant message) {
+			if (!holds_alternative<binary>(message))
+				return;
+
+			// Each payload is filled with the low byte of its sequence number
+			auto &packet = get<binary>(message);
+			auto rtp = reinterpret_cast<const RTP *>(packet.data());
+			bool valid = packet.size() == rtp->getSize() + payloadSize && rtp->ssrc() == ssrc &&
+			             rtp->payloadType() == payloadType;
+			for (size_t i = rtp->getSize(); valid && i < packet.size(); ++i)
+				valid = packet[i] == byte(rtp->seqNumber() & 0xFF);
+
+			std::lock_guard lock(mutex);
+			if (valid)
+				received.push_back(rtp->seqNumber());
+			else
+				++invalidCount;
+		});
+	});
+
+	Description::Video media("video", Description::Direction::SendOnly);
+	media.addH264Codec(payloadType);
+	media.addSSRC(ssrc, "video-send");
+	auto t1 = pc1.addTrack(media);
+	t1->setMediaHandler(bridge);
+
+	pc1.setLocalDescription();
+
+	int attempts = 10;
+	while (!t1->isOpen() && attempts--)
+		this_thread::sleep_for(1s);
+
+	if (!t1->isOpen())
+		throw runtime_error("Track is not open");
+
+	int sock = ::socket(AF_INET, SOCK_DGRAM, 0);
+	if (sock < 0)
+		throw runtime_error("UDP socket creation failed");
+
+	sockaddr_in addr = {};
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	addr.sin_port = htons(bridge->port());
+
+	const uint16_t count = 64;
+	for (uint16_t seqNumber = 0; seqNumber < count; ++seqNumber) {
+		binary packet(sizeof(RTP), byte(0));
+		auto rtp = reinterpret_cast<RTP *>(packet.data());
+		rtp->preparePacket();
+		rtp->setPayloadType(100);
+		rtp->setSsrc(1234);
+		rtp->setSeqNumber(seqNumber);
+		packet.resize(rtp->getSize() + payloadSize, byte(seqNumber & 0xFF));
+		::sendto(sock, reinterpret_cast<const char *>(packet.data()), packet.size(), 0,
+		         reinterpret_cast<const sockaddr *>(&addr), sizeof(addr));
+	}
+	::close(sock);
+
+	attempts = 50;
+	while (attempts--) {
+		this_thread::sleep_for(100ms);
+		std::lock_guard lock(mutex);
+		if (received.size() + invalidCount >= count)
+			break;
+	}
+
+	bridge->stop();
+	pc1.close();
+	pc2.close();
+
+	// A runtime fallback, like io_uring without multishot receive, leaves packets on the socket
+	size_t pathCount = bridge->receivedCount(backend);
+	bool fellBack = bridge->backend() != backend;
+
+	std::lock_guard lock(mutex);
+	cout << "Received " << received.size() << " packets, " << invalidCount << " invalid, "
+	     << pathCount << " through " << name << endl;
+
+	if (invalidCount > 0)
+		throw runtime_error("Bridge forwarded invalid packets");
+
+	// Loopback does not lose or reorder packets, and ordering over the track is preserved
+	if (received.size() != count)
+		throw runtime_error("Bridge did not forward all packets");
+
+	for (uint16_t i = 0; i < count; ++i)
+		if (received[i] != i)
+			throw runtime_error("Bridge reordered packets");
+
+	if (fellBack)
+		cout << name << " fell back to the socket at runtime" << endl;
+	else if (pathCount != count)
+		throw runtime_error("Packets were not received through " + name);
+}
+#endif
+
+} // namespace
+
+void test_rtpbridge() {
+	InitLogger(LogLevel::Warning);
+
+#ifndef _WIN32
+	cout << "Receiving with recvmmsg" << endl;
+	test_rtpbridge_receive(RtpBridge::Configuration{}, RtpBridge::Backend::Socket, "recvmmsg");
+
+#ifdef __linux__
+	// Falls back to recvmmsg if io_uring is not supported by the kernel
+	cout << "Receiving with io_uring" << endl;
+	RtpBridge::Configuration uringConfig;
+	uringConfig.enableIoUring = true;
+	test_rtpbridge_receive(uringConfig, RtpBridge::Backend::IoUring, "io_uring");
+
+	// Generic XDP on the loopback interface, falls back to the socket without CAP_NET_ADMIN,
+	// CAP_NET_RAW, and CAP_BPF
+	cout << "Receiving with AF_XDP on lo" << endl;
+	RtpBridge::Configuration xdpConfig;
+	xdpConfig.xdpInterface = "lo";
+	test_rtpbridge_receive(xdpConfig, RtpBridge::Backend::Xdp, "AF_XDP");
+#endif
+#else
+	cout << "RTP bridge test requires POSIX sockets, skipped" << endl;
+#endif
+}
+
+#endif
@@ -26,9 +26,31 @@
 
 using namespace rtc;
 using namespace std;
+using namespace std::chrono_literals;
 
 template <class T> weak_ptr<T> make_weak_ptr(shared_ptr<T> ptr) { return ptr; }
 
+// Checks the arrival time of incoming packets is set on reception
+class ArrivalChecker final : public MediaHandler {
+public:
+	message_ptr incoming(message_ptr message) override {
+		if (message->type == Message::Binary) {
+			auto now = chrono::steady_clock::now();
+			if (message->arrival != chrono::steady_clock::time_point{} && message->arrival <= now &&
+			    now - message->arrival < 1s)
+				++validCount;
+			else
+				++invalidCount;
+		}
+		return message;
+	}
+
+	message_ptr outgoing(message_ptr message) override { return message; }
+
+	atomic<int> validCount = 0;
+	atomic<int> invalidCount = 0;
+};
+
 void test_track() {
 	InitLogger(LogLevel::Debug);
 
@@ -111,7 +133,9 @@ void test_track() {
 
 	// Test renegotiation
 	newTrackMid = "added";
-	t1 = pc1.addTrack(Description::Video(newTrackMid));
+	Description::Video media(newTrackMid);
+	media.addSSRC(42, "added");
+	t1 = pc1.addTrack(media);
 
 	pc1.setLocalDescription();
 
@@ -123,7 +147,31 @@ void test_track() {
 	if (!at2 || !at2->isOpen() || !t1->isOpen())
 		throw runtime_error("Renegotiated track is not open");
 
-	// TODO: Test sending RTP packets in track
+	// Test sending RTP packets in track
+	auto checker = make_shared<ArrivalChecker>();
+	at2->setMediaHandler(checker);
+
+	binary packet(12 + 4, byte(0));
+	auto rtp = reinterpret_cast<RTP *>(packet.data());
+	rtp->preparePacket();
+	rtp->setPayloadType(96);
+	rtp->setSsrc(42);
+	for (uint16_t i = 0; i < 10; ++i) {
+		rtp->setSeqNumber(i);
+		rtp->setTimestamp(i * 3000);
+		t1->send(packet);
+		this_thread::sleep_for(10ms);
+	}
+
+	attempts = 10;
+	while (checker->validCount + checker->invalidCount < 10 && attempts--)
+		this_thread::sleep_for(100ms);
+
+	if (checker->validCount == 0)
+		throw runtime_error("No RTP packet received");
+
+	if (checker->invalidCount > 0)
+		throw runtime_error("Received RTP packet has invalid arrival time");
 
 	// Delay close of peer 2 to check closing works properly
 	pc1.close();
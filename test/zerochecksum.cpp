@@ -0,0 +1,148 @@
+/**
+ * Copyright (c) 2021 Paul-Louis Ageneau
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "impl/crc32c.hpp"
+#include "impl/sctppacket.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+using namespace rtc::impl;
+using namespace std;
+
+namespace {
+
+// Bitwise reference, independent of the table and of the CRC instructions
+uint32_t crc32c_reference(const byte *data, size_t size) {
+	uint32_t crc = 0xFFFFFFFF;
+	for (size_t i = 0; i < size; ++i) {
+		crc ^= to_integer<uint32_t>(data[i]);
+		for (int j = 0; j < 8; ++j)
+			crc = (crc >> 1) ^ (crc & 1 ? 0x82F63B78 : 0);
+	}
+	return ~crc;
+}
+
+void append_uint16(vector<byte> &packet, uint16_t value) {
+	packet.push_back(byte(value >> 8));
+	packet.push_back(byte(value & 0xFF));
+}
+
+void append_uint32(vector<byte> &packet, uint32_t value) {
+	append_uint16(packet, uint16_t(value >> 16));
+	append_uint16(packet, uint16_t(value & 0xFFFF));
+}
+
+// Builds a packet with an INIT or INIT ACK chunk followed by the given parameters
+vector<byte> make_init_packet(uint8_t chunkType, const vector<byte> &params) {
+	vector<byte> packet(SCTP_COMMON_HEADER_SIZE, byte(0));
+	packet.push_back(byte(chunkType));
+	packet.push_back(byte(0)); // flags
+	append_uint16(packet, uint16_t(20 + params.size()));
+	append_uint32(packet, 0x12345678); // initiate tag
+	append_uint32(packet, 65536);      // a_rwnd
+	append_uint16(packet, 1024);       // outbound streams
+	append_uint16(packet, 1024);       // inbound streams
+	append_uint32(packet, 1);          // initial TSN
+	packet.insert(packet.end(), params.begin(), params.end());
+	return packet;
+}
+
+vector<byte> make_param(uint16_t type, const vector<byte> &value) {
+	vector<byte> param;
+	append_uint16(param, type);
+	append_uint16(param, uint16_t(4 + value.size()));
+	param.insert(param.end(), value.begin(), value.end());
+	while (param.size() % 4)
+		param.push_back(byte(0)); // padding
+	return param;
+}
+
+vector<byte> make_zero_checksum_param(uint32_t edmid) {
+	vector<byte> value;
+	append_uint32(value, edmid);
+	return make_param(SCTP_PARAM_ZERO_CHECKSUM_ACCEPTABLE, value);
+}
+
+} // namespace
+
+void test_zero_checksum() {
+	// Known vector, see https://tools.ietf.org/html/rfc3720#appendix-B.4
+	const char *check = "123456789";
+	if (Crc32c(reinterpret_cast<const byte *>(check), strlen(check)) != 0xE3069283)
+		throw runtime_error("Wrong CRC32c for the check string");
+
+	// Cover the word and tail loops of the hardware path with every alignment
+	vector<byte> buffer(300 + 8);
+	for (size_t i = 0; i < buffer.size(); ++i)
+		buffer[i] = byte((i * 131 + 7) & 0xFF);
+
+	for (size_t offset = 0; offset < 8; ++offset)
+		for (size_t size = 0; size <= 300; ++size)
+			if (Crc32c(buffer.data() + offset, size) !=
+			    crc32c_reference(buffer.data() + offset, size))
+				throw runtime_error("CRC32c differs from the reference, size=" +
+				                    to_string(size) + ", offset=" + to_string(offset));
+
+	// The checksum is stored in little-endian order
+	vector<byte> header(SCTP_COMMON_HEADER_SIZE, byte(0));
+	sctp_write_checksum(header.data(), 0xE3069283);
+	if (header[SCTP_CHECKSUM_OFFSET] != byte(0x83) ||
+	    header[SCTP_CHECKSUM_OFFSET + 3] != byte(0xE3))
+		throw runtime_error("Checksum is not written in little-endian order");
+
+	if (sctp_read_checksum(header.data()) != 0xE3069283)
+		throw runtime_error("Checksum read differs from the one written");
+
+	// Zero Checksum Acceptable with DTLS is found in INIT and INIT ACK
+	auto init = make_init_packet(SCTP_CHUNK_INIT, make_zero_checksum_param(SCTP_EDMID_DTLS));
+	if (sctp_first_chunk_type(init.data(), init.size()) != SCTP_CHUNK_INIT)
+		throw runtime_error("Wrong first chunk type");
+
+	if (!sctp_has_zero_checksum_acceptable(init.data(), init.size()))
+		throw runtime_error("Zero Checksum Acceptable not found in INIT");
+
+	// After another parameter with padding
+	auto params = make_param(0xC000, {byte(1)}); // Forward-TSN supported, padded to 8
+	auto zeroChecksum = make_zero_checksum_param(SCTP_EDMID_DTLS);
+	params.insert(params.end(), zeroChecksum.begin(), zeroChecksum.end());
+	auto initAck = make_init_packet(SCTP_CHUNK_INIT_ACK, params);
+	if (!sctp_has_zero_checksum_acceptable(initAck.data(), initAck.size()))
+		throw runtime_error("Zero Checksum Acceptable not found after a padded parameter");
+
+	// Another Error Detection Method, no parameter, or a truncated packet are not accepted
+	auto otherMethod = make_init_packet(SCTP_CHUNK_INIT, make_zero_checksum_param(0));
+	if (sctp_has_zero_checksum_acceptable(otherMethod.data(), otherMethod.size()))
+		throw runtime_error("Zero Checksum Acceptable accepted with another method");
+
+	auto none = make_init_packet(SCTP_CHUNK_INIT, {});
+	if (sctp_has_zero_checksum_acceptable(none.data(), none.size()))
+		throw runtime_error("Zero Checksum Acceptable found without parameter");
+
+	if (sctp_has_zero_checksum_acceptable(init.data(), init.size() - 1))
+		throw runtime_error("Zero Checksum Acceptable found in a truncated packet");
+
+	if (sctp_has_zero_checksum_acceptable(init.data(), SCTP_COMMON_HEADER_SIZE))
+		throw runtime_error("Zero Checksum Acceptable found without chunk");
+
+	cout << "Success" << endl;
+}